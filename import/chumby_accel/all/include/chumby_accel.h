@@ -74,6 +74,8 @@ typedef enum
     ACCEL_CMD_LOCKROM         = 0x82, 
     ACCEL_CMD_UNLOCKROM       = 0x83, 
     ACCEL_CMD_READSTAT        = 0x84, 
+    ACCEL_CMD_READROM_BULK    = 0x85,
+    ACCEL_CMD_SETROM_BULK     = 0x86,
 
     /* Insert new ioctls here                                               */
 
@@ -89,6 +91,8 @@ typedef enum
 #define ACCEL_IOCTL_READSTAT     _IOWR(  ACCEL_IOCTL_MAGIC, ACCEL_CMD_READSTAT, int )     // arg is int
 #define ACCEL_IOCTL_LOCKROM      _IOWR(  ACCEL_IOCTL_MAGIC, ACCEL_CMD_LOCKROM, int ) 
 #define ACCEL_IOCTL_UNLOCKROM    _IOWR(  ACCEL_IOCTL_MAGIC, ACCEL_CMD_UNLOCKROM, int )
+#define ACCEL_IOCTL_READROM_BULK _IOWR(  ACCEL_IOCTL_MAGIC, ACCEL_CMD_READROM_BULK, struct eeprom_bulk_data )  // arg is struct eeprom_bulk_data
+#define ACCEL_IOCTL_SETROM_BULK  _IOWR(  ACCEL_IOCTL_MAGIC, ACCEL_CMD_SETROM_BULK, struct eeprom_bulk_data )   // arg is struct eeprom_bulk_data
 
 /*
  * The following are for entries in /proc/sys/chumbend
@@ -133,3 +137,11 @@ struct eeprom_data {
   unsigned char data;    // data to be written (or read data upon return)
 };
 
+// for the bulk commands. writes are split at rom page boundaries by the driver. drivers
+// which predate these commands fail them with ENOTTY
+struct eeprom_bulk_data {
+  unsigned int address;  // address of the first byte
+  unsigned int length;   // number of bytes
+  unsigned char *data;   // user buffer, data to be written (or read data upon return)
+};
+
@@ -0,0 +1,42 @@
+/*
+ * dcid_accel.h
+ *
+ * dcid contributors
+ * (c) Copyright 2026
+ * All rights reserved
+ *
+ * This API defines the hooks of the chumby_accel DCID backend (ironforge). The backend
+ * moves whole blocks with the bulk ROM ioctls where the driver has them, and falls back to
+ * one ioctl per byte where it does not. Every request goes through a replaceable handler,
+ * so the backend can be exercised against a stub driver without a board.
+ */
+
+#ifndef DCID_ACCEL_H
+#define DCID_ACCEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "dcid_backend.h"
+
+/*! ioctl handler, with the calling convention of ioctl(2) */
+typedef int (*dcid_accel_ioctl_t)(int fd, unsigned long request, void *arg);
+
+/*!
+
+ Replace the handler through which the backend issues chumby_accel requests. Affects
+ dcid_backend_ironforge for all instances.
+
+  @param handler (INP) - Handler, or 0 for ioctl(2)
+  @return DCID_OK for success, otherwise DCID_ error code
+
+ */
+
+int dcid_accel_set_ioctl(dcid_accel_ioctl_t handler);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
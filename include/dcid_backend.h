@@ -0,0 +1,106 @@
+/*
+ * dcid_backend.h
+ *
+ * dcid contributors
+ * (c) Copyright 2026
+ * All rights reserved
+ *
+ * This API defines the device backends used by dcid_interface. A backend moves blocks of
+ * bytes between the card and memory, and advertises the transfer sizes it handles best.
+ * All batching, caching and diffing happens above it.
+ */
+
+#ifndef DCID_BACKEND_H
+#define DCID_BACKEND_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/*! \name forward declarations */
+/*! \{ */
+struct _dcid_t;
+/*! \} */
+
+/*!
+
+  @brief DCID backend capabilities
+
+  Transfer granularity of a backend. The core never asks for more than max_read bytes per
+  read_block call, and never passes a write_block range which crosses a multiple of
+  write_page.
+
+*/
+
+typedef struct _dcid_backend_caps_t
+{
+    /*! largest read_block transfer, in bytes */
+    int max_read;
+    /*! largest write_block transfer, in bytes. writes never cross a multiple of this size */
+    int write_page;
+    /*! typical time the device stays busy after each write_block, in microseconds, 0 if none */
+    int write_cycle_us;
+}
+dcid_backend_caps_t;
+
+/*!
+
+  @brief DCID backend operations
+
+  Entry points of a backend. Each returns DCID_OK for success, otherwise a DCID_ error
+  code. Addresses are card addresses, and may reach past DCID_MAX_ADDRESS for the card
+  revision and serial number.
+
+*/
+
+typedef struct _dcid_backend_t
+{
+    /*! backend name, for diagnostics */
+    const char *name;
+    /*! transfer granularity */
+    dcid_backend_caps_t caps;
+    /*! backend specific settings, e.g. bus addresses */
+    const void *config;
+
+    /*! open device at path, setting device_file */
+    int (*open)(struct _dcid_t *p_dcid, const char *path);
+    /*! read size bytes at addr */
+    int (*read_block)(struct _dcid_t *p_dcid, unsigned int addr, uint8_t *data, int size);
+    /*! make the device writable, ahead of the writes of a flush. 0 if writes need no preparation */
+    int (*prepare)(struct _dcid_t *p_dcid);
+    /*! write size bytes at addr, returning once the device accepts further requests */
+    int (*write_block)(struct _dcid_t *p_dcid, unsigned int addr, const uint8_t *data, int size);
+    /*! commit preceding writes to stable storage, and undo prepare. called at the end of every
+     *  flush, including one cut short by a failed write. 0 if there is nothing to do */
+    int (*flush)(struct _dcid_t *p_dcid);
+    /*! close device */
+    int (*close)(struct _dcid_t *p_dcid);
+}
+dcid_backend_t;
+
+/*! \name DCID backends */
+/*! \{ */
+extern const dcid_backend_t dcid_backend_falconwing;    /*!< 24C08 EEPROM at i2c address 0xA8, via I2C_RDWR */
+extern const dcid_backend_t dcid_backend_silvermoon;    /*!< 24C08 EEPROM at i2c address 0x50, via I2C_RDWR */
+extern const dcid_backend_t dcid_backend_ironforge;     /*!< SPI EEPROM via chumby_accel ioctls (see dcid_accel.h) */
+extern const dcid_backend_t dcid_backend_emmc;          /*!< "dcid" block of the eMMC config area, fdatasync on flush */
+extern const dcid_backend_t dcid_backend_emmc_direct;   /*!< "dcid" block of the eMMC config area, O_DIRECT and fdatasync */
+extern const dcid_backend_t dcid_backend_emmc_nosync;   /*!< "dcid" block of the eMMC config area, no sync (scratch use) */
+extern const dcid_backend_t dcid_backend_file;          /*!< plain file */
+extern const dcid_backend_t dcid_backend_mmap;          /*!< plain file, mapped into memory, msync on flush */
+extern const dcid_backend_t dcid_backend_mmap_nosync;   /*!< plain file, mapped into memory, no sync (scratch use) */
+/*! \} */
+
+/*! backend for the platform this library was built for */
+const dcid_backend_t *dcid_backend_default(void);
+
+/*! backend by name (e.g. "silvermoon", "file", "sim"), 0 if there is no such backend */
+const dcid_backend_t *dcid_backend_find(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,120 @@
+/*
+ * dcid_daemon.h
+ *
+ * dcid contributors
+ * (c) Copyright 2026
+ * All rights reserved
+ *
+ * This API defines a resident DCID server, and the client calls used to query it. The
+ * server owns the device, keeps the image in memory, and answers requests over a Unix
+ * domain socket, so that many processes can read the card without each one scanning the
+ * bus. Writes are serialized through the server.
+ */
+
+#ifndef DCID_DAEMON_H
+#define DCID_DAEMON_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "dcid_interface.h"
+
+/*! default server socket path. its directory must be writable by nobody but root */
+#ifndef DCID_DAEMON_SOCKET_PATH
+#define DCID_DAEMON_SOCKET_PATH "/var/run/dcid/dcid.sock"
+#endif
+
+/*! \name DCID daemon request codes */
+/*! \{ */
+#define DCID_DAEMON_READ_XML     0x0001  /*!< dcid_read_xml */
+#define DCID_DAEMON_READ_IMAGE   0x0002  /*!< dcid_read_image */
+#define DCID_DAEMON_GET          0x0003  /*!< dcid_get, payload is the null terminated path */
+#define DCID_DAEMON_WRITE_XML    0x0004  /*!< dcid_write_xml, payload is the XML data, refused if it ends inside a record */
+/*! \} */
+
+/*!
+
+ @brief DCID daemon message header
+
+ Every request and reply starts with this header, in host byte order. For a request, op
+ is the request code, size is the largest reply payload the client accepts, and len is
+ the request payload length. For a reply, op is the DCID_ return code, size is the size
+ reported by the call (e.g. the required size along with DCID_BUFFER_TOO_SMALL), and len
+ is the reply payload length.
+
+*/
+
+typedef struct _dcid_daemon_msg_t
+{
+    int32_t op;
+    int32_t size;
+    int32_t len;
+}
+dcid_daemon_msg_t;
+
+/*!
+
+ Serve requests for an initialized DCID instance until an unrecoverable error occurs. The
+ image is loaded before the socket is created, so clients never wait on the device for
+ reads. Requests are carried out one at a time, with connected clients taking turns one
+ request each. Anyone may connect and read. Write requests are refused with
+ DCID_ACCESS_DENIED unless built with DCID_ALLOW_WRITE, and unless the client runs as
+ root (or as the same user as the server).
+
+ The socket directory is created if missing. It must belong to root (or the server's
+ user) and be writable by nobody else, so that no other user can plant a socket in it.
+
+  @param p_dcid (INP) - DCID instance
+  @param socket_path (INP) - Socket path, or 0 for DCID_DAEMON_SOCKET_PATH
+  @return DCID_ACCESS_DENIED if another server is already running, or the socket directory
+          is not safe, otherwise DCID_ error code
+
+ */
+
+int dcid_daemon_run(struct _dcid_t *p_dcid, const char *socket_path);
+
+/*!
+
+ Connect to a running DCID server. Only a server run by root (or by the calling user) is
+ accepted.
+
+  @param socket_path (INP) - Socket path, or 0 for DCID_DAEMON_SOCKET_PATH
+  @param p_fd (OUT) - Connection handle
+  @return DCID_OK for success, DCID_NOT_FOUND if no server is running, DCID_ACCESS_DENIED
+          if the server is run by another user, otherwise DCID_ error code
+
+ */
+
+int dcid_client_open(const char *socket_path, int *p_fd);
+
+/*!
+
+ Close a connection to a DCID server.
+
+  @param fd (INP) - Connection handle
+  @return DCID_OK for success, otherwise DCID_ error code
+
+ */
+
+int dcid_client_close(int fd);
+
+/*! dcid_read_xml, answered by a DCID server */
+int dcid_client_read_xml(int fd, char *xml_data, int *p_size);
+
+/*! dcid_read_image, answered by a DCID server */
+int dcid_client_read_image(int fd, uint8_t *raw_data, int *p_size);
+
+/*! dcid_get, answered by a DCID server */
+int dcid_client_get(int fd, const char *path, uint8_t *data, int *p_size);
+
+/*! dcid_write_xml, carried out by a DCID server. as with dcid_write_end, a document that ends
+ *  inside a record fails. on success *p_size is the number of XML bytes the server consumed,
+ *  which is all of them, otherwise it is 0 */
+int dcid_client_write_xml(int fd, char *xml_data, int *p_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -23,6 +23,14 @@ extern "C" {
 /*! \{ */
 struct _dcid_info_t;
 struct _dcid_t;
+struct _dcid_iter_t;
+struct _dcid_index_t;
+struct _dcid_shm_t;
+struct _dcid_backend_t;
+struct _dcid_stats_t;
+struct _dcid_trace_t;
+struct _dcid_flush_t;
+struct _dcid_writer_t;
 /*! \} */
 
 /*!
@@ -75,6 +83,40 @@ int dcid_init(struct _dcid_t *p_dcid, char *dcid_device_path);
 
 int dcid_read_xml(struct _dcid_t *p_dcid, char *xml_data, int *p_size);
 
+/*!
+
+ Read the raw image from the Daughter Card ID Interface. The image is fetched from the
+ device once, using the largest transfers the platform supports, and kept in memory so
+ that later reads (including dcid_read_xml) do not touch the device again.
+
+  @param p_dcid (INP) - DCID instance
+  @param raw_data (OUT) - Raw image bytes
+  @param p_size (INP/OUT) - INP: Max size, in bytes, to write to raw_data buffer.
+                            OUT: Returns number of bytes written (at most DCID_MAX_RAW_SIZE).
+  @return DCID_OK for success, otherwise DCID_ error code
+
+ */
+
+int dcid_read_image(struct _dcid_t *p_dcid, uint8_t *raw_data, int *p_size);
+
+/*!
+
+ Look up a single record by path, e.g. "nod1/nod3/nod4". Only record headers are read
+ while searching; sibling records are skipped using their size field, so on byte oriented
+ devices a lookup touches a few dozen bytes rather than the whole image.
+
+  @param p_dcid (INP) - DCID instance
+  @param path (INP) - '/' separated list of 4 character tags, starting at the top level
+  @param data (OUT) - Record payload
+  @param p_size (INP/OUT) - INP: Max size, in bytes, to write to data buffer.
+                            OUT: Returns payload size. If the buffer is too small, the
+                            required size is returned along with DCID_BUFFER_TOO_SMALL.
+  @return DCID_OK for success, DCID_NOT_FOUND if there is no such record, otherwise DCID_ error code
+
+ */
+
+int dcid_get(struct _dcid_t *p_dcid, const char *path, uint8_t *data, int *p_size);
+
 /*!
 
  Write XML data to the Daughter Card ID Interface.
@@ -89,6 +131,289 @@ int dcid_read_xml(struct _dcid_t *p_dcid, char *xml_data, int *p_size);
 
 int dcid_write_xml(struct _dcid_t *p_dcid, char *xml_data, int *p_size);
 
+/*!
+
+ Stage XML data in the write cache, without writing to the device. The staged image is
+ committed by dcid_write_flush or dcid_write_flush_async. dcid_write_xml is this call
+ followed by dcid_write_flush.
+
+  @param p_dcid (INP) - DCID instance
+  @param xml_data (INP) - Null terminated XML data in ASCII char encoding
+  @param p_size (INP) - Unused, and left unchanged. Must not be null; kept only so the
+                        signature matches dcid_write_xml.
+  @return DCID_OK for success, otherwise DCID_ error code
+
+ */
+
+int dcid_stage_xml(struct _dcid_t *p_dcid, char *xml_data, int *p_size);
+
+/*!
+
+ Begin writing an XML document delivered in pieces, e.g. as it is read from a pipe. The
+ document is encoded as it arrives, so memory use does not depend on its size or layout,
+ and staged in the write cache as dcid_stage_xml would stage it whole. Beginning again
+ abandons any document in progress.
+
+  @param p_dcid (INP) - DCID instance
+  @return DCID_OK for success, otherwise DCID_ error code
+
+ */
+
+int dcid_write_begin(struct _dcid_t *p_dcid);
+
+/*!
+
+ Feed the next piece of a document begun with dcid_write_begin. Pieces may split the
+ document anywhere, including inside a tag or a hex byte. A null character ends the
+ document, and anything fed after it is ignored. Once a piece fails, later ones return
+ the same error.
+
+  @param p_dcid (INP) - DCID instance
+  @param xml_data (INP) - XML data in ASCII char encoding, not necessarily null terminated
+  @param size (INP) - Size of xml_data, in bytes
+  @return DCID_OK for success, DCID_INVALID_CALL if no document was begun, otherwise DCID_ error code
+
+ */
+
+int dcid_write_feed(struct _dcid_t *p_dcid, const char *xml_data, int size);
+
+/*!
+
+ Finish a document begun with dcid_write_begin. Unlike dcid_write_xml, a document that ends
+ inside a record was cut short, so it fails and nothing is committed. Whatever it staged is
+ left in the write cache until the next document overwrites it.
+
+  @param p_dcid (INP) - DCID instance
+  @param flush (INP) - Non-zero to commit the document as dcid_write_xml would, zero to
+                       leave it staged for dcid_write_flush or dcid_write_flush_async
+  @return DCID_OK for success, DCID_INVALID_CALL if no document was begun, DCID_FAIL if the
+          document ended inside a record, otherwise DCID_ error code
+
+ */
+
+int dcid_write_end(struct _dcid_t *p_dcid, int flush);
+
+/*!
+
+ Commit everything staged in the write cache to the device, returning once it is done.
+
+  @param p_dcid (INP) - DCID instance
+  @return DCID_OK for success, otherwise DCID_ error code
+
+ */
+
+int dcid_write_flush(struct _dcid_t *p_dcid);
+
+/*! flush completion callback. result is the DCID_ code dcid_flush_wait will return */
+typedef void (*dcid_flush_callback_t)(struct _dcid_t *p_dcid, int result, void *p_context);
+
+/*!
+
+ Commit everything staged in the write cache to the device on a worker thread, returning
+ at once. Completion is signalled three ways: the callback, if any, is called on the
+ worker thread; the descriptor from dcid_flush_fd becomes readable; and dcid_flush_wait
+ returns.
+
+ While the flush is in progress, only dcid_flush_progress, dcid_flush_fd, dcid_flush_wait
+ and dcid_flush_cancel return at once. Every other call on the instance first waits for
+ the flush to finish, so a read always sees the committed data. The callback must only
+ use dcid_flush_progress on the instance.
+
+  @param p_dcid (INP) - DCID instance
+  @param callback (INP) - Completion callback, or 0 for none
+  @param p_context (INP) - Passed to callback
+  @return DCID_OK if the flush was started, otherwise DCID_ error code
+
+ */
+
+int dcid_write_flush_async(struct _dcid_t *p_dcid, dcid_flush_callback_t callback, void *p_context);
+
+/*!
+
+ Report progress of the last flush started by dcid_write_flush_async.
+
+  @param p_dcid (INP) - DCID instance
+  @param p_done (OUT) - Bytes committed so far
+  @param p_total (OUT) - Bytes to commit, known once the worker has compared the write
+                         cache against the device, 0 before then
+  @return DCID_OK for success, otherwise DCID_ error code
+
+ */
+
+int dcid_flush_progress(struct _dcid_t *p_dcid, int *p_done, int *p_total);
+
+/*!
+
+ Fetch a descriptor which becomes readable once a flush started by dcid_write_flush_async
+ has finished, for use with poll or select. It stays readable until dcid_flush_wait, and
+ belongs to the instance, so the caller must not read or close it.
+
+  @param p_dcid (INP) - DCID instance
+  @param p_fd (OUT) - Descriptor
+  @return DCID_OK for success, otherwise DCID_ error code
+
+ */
+
+int dcid_flush_fd(struct _dcid_t *p_dcid, int *p_fd);
+
+/*!
+
+ Wait for a flush started by dcid_write_flush_async to finish.
+
+  @param p_dcid (INP) - DCID instance
+  @return Result of the last flush started, DCID_CANCELLED if it was cancelled, or DCID_OK
+          if none was ever started
+
+ */
+
+int dcid_flush_wait(struct _dcid_t *p_dcid);
+
+/*!
+
+ Ask a flush started by dcid_write_flush_async to stop, returning at once. The worker
+ stops before its next device write. Whatever it already wrote stays on the device, and
+ the rest stays staged for a later flush. Use dcid_flush_wait to learn whether the flush
+ stopped or had already completed.
+
+  @param p_dcid (INP) - DCID instance
+  @return DCID_OK for success, otherwise DCID_ error code
+
+ */
+
+int dcid_flush_cancel(struct _dcid_t *p_dcid);
+
+/*!
+
+ Encode XML into a raw image, entirely in memory. No instance or device is involved, which
+ makes this suitable for preparing images offline. The output is the same image that
+ dcid_write_xml would stage for the device.
+
+  @param xml_data (INP) - XML data in ASCII char encoding, null terminated
+  @param raw_data (OUT) - Raw image bytes
+  @param p_size (INP/OUT) - INP: Max size, in bytes, to write to raw_data buffer.
+                            OUT: Returns image size. If the buffer is too small, the
+                            required size is returned along with DCID_BUFFER_TOO_SMALL.
+  @return DCID_OK for success, otherwise DCID_ error code
+
+ */
+
+int dcid_encode_xml(const char *xml_data, uint8_t *raw_data, int *p_size);
+
+/*!
+
+ Decode a raw image into XML, entirely in memory. The output is the same XML that
+ dcid_read_xml would return for a card holding this image.
+
+  @param raw_data (INP) - Raw image bytes
+  @param raw_size (INP) - Size of raw_data, in bytes (at most DCID_MAX_RAW_SIZE)
+  @param xml_data (OUT) - XML data in ASCII char encoding
+  @param p_size (INP/OUT) - INP: Max size, in bytes, to write to xml_data buffer.
+                            OUT: Returns number of bytes written (incl null terminator).
+  @return DCID_OK for success, otherwise DCID_ error code
+
+ */
+
+int dcid_decode_image(const uint8_t *raw_data, int raw_size, char *xml_data, int *p_size);
+
+/*!
+
+ Fetch the performance counters of an instance, accumulated since dcid_create or the
+ last dcid_reset_stats.
+
+  @param p_dcid (INP) - DCID instance
+  @param p_stats (OUT) - Counters
+  @return DCID_OK for success, otherwise DCID_ error code
+
+ */
+
+int dcid_get_stats(struct _dcid_t *p_dcid, struct _dcid_stats_t *p_stats);
+
+/*!
+
+ Reset the performance counters of an instance to zero.
+
+  @param p_dcid (INP) - DCID instance
+  @return DCID_OK for success, otherwise DCID_ error code
+
+ */
+
+int dcid_reset_stats(struct _dcid_t *p_dcid);
+
+/*!
+
+ Begin walking the records of the DCID image, without rendering XML. On success the
+ iterator is positioned on the first top level record. Tags and payloads are handed out
+ as pointers into the instance's image, which remain valid until the next write or
+ dcid_close.
+
+  @param p_dcid (INP) - DCID instance
+  @param p_iter (OUT) - Iterator to initialize
+  @return DCID_OK for success, DCID_NOT_FOUND for an empty image, otherwise DCID_ error code
+
+ */
+
+int dcid_iter_begin(struct _dcid_t *p_dcid, struct _dcid_iter_t *p_iter);
+
+/*!
+
+ Advance to the next record at the current nesting level.
+
+  @param p_iter (INP/OUT) - Iterator
+  @return DCID_OK for success, DCID_NOT_FOUND past the last record, otherwise DCID_ error code
+
+ */
+
+int dcid_iter_next(struct _dcid_iter_t *p_iter);
+
+/*!
+
+ Descend into the current record, which must be a container. On success the iterator is
+ positioned on its first child.
+
+  @param p_iter (INP/OUT) - Iterator
+  @return DCID_OK for success, DCID_NOT_FOUND for an empty container, otherwise DCID_ error code
+
+ */
+
+int dcid_iter_enter(struct _dcid_iter_t *p_iter);
+
+/*!
+
+ Return to the enclosing level. On success the iterator is positioned on the container
+ that was entered.
+
+  @param p_iter (INP/OUT) - Iterator
+  @return DCID_OK for success, otherwise DCID_ error code
+
+ */
+
+int dcid_iter_leave(struct _dcid_iter_t *p_iter);
+
+/*!
+
+  @brief DCID performance counters
+
+  Counts what an instance asked of its device, and where its time went. Transactions
+  are counted as the backend issues them (e.g. one ioctl or one pread), so a byte
+  oriented device shows one transaction per byte.
+
+*/
+
+typedef struct _dcid_stats_t
+{
+    uint32_t transactions;  /*!< device transactions issued, including write cycle polls, syncs and control requests */
+    uint32_t read_bytes;    /*!< bytes read from the device */
+    uint32_t write_bytes;   /*!< bytes written to the device */
+    uint32_t seeks;         /*!< block device accesses not following on from the previous one */
+    uint32_t sleeps;        /*!< sleeps, e.g. while waiting out an EEPROM write cycle */
+    uint64_t sleep_us;      /*!< time spent in sleeps, in microseconds */
+    uint64_t read_us;       /*!< time spent reading the device, in microseconds */
+    uint64_t parse_us;      /*!< time spent rendering the image as XML, in microseconds */
+    uint64_t encode_us;     /*!< time spent encoding XML into the write cache, in microseconds */
+    uint64_t flush_us;      /*!< time spent flushing the write cache to the device, in microseconds */
+}
+dcid_stats_t;
+
 /*! 
 
   @brief DCID instance
@@ -101,10 +426,50 @@ typedef struct _dcid_t
 {
     /*! dcid device file handle */
     int device_file;
+    /*! device backend */
+    const struct _dcid_backend_t *backend;
+    /*! backend private state, 0 if none */
+    void *backend_data;
     /*! initialization flag */
     int is_initialized;
-    /*! write cache, to prevent partial writes. value above 255 implies no cached value */
-    uint16_t *write_cache;
+    /*! write cache, to prevent partial writes. only positions flagged in write_dirty hold a value */
+    uint8_t *write_cache;
+    /*! bitmap of write cache positions not yet flushed, one bit per address */
+    uint32_t *write_dirty;
+    /*! shadow copy of the device image, DCID_MAX_RAW_SIZE bytes */
+    uint8_t *image;
+    /*! shadow image flag, set once image holds the current device contents */
+    int image_valid;
+    /*! tag index over the shadow image */
+    struct _dcid_index_t *index;
+    /*! tag index flag, set once index matches the shadow image */
+    int index_valid;
+    /*! maximum number of acknowledge polls after each device write */
+    int write_poll_limit;
+    /*! maximum time, in microseconds, to wait for a device write cycle to complete */
+    int write_timeout_us;
+    /*! device offset of the dcid block within the config area, -1 if not yet located */
+    int64_t block_offset;
+    /*! config area signature observed when block_offset was located */
+    char block_sig[4];
+    /*! directory holding the on-disk cache, 0 if caching is disabled */
+    char *cache_dir;
+    /*! rendered XML taken from the on-disk cache, 0 if none */
+    char *cache_xml;
+    /*! size of cache_xml, in bytes (incl null terminator) */
+    int cache_xml_size;
+    /*! shared memory snapshot kept current by this instance, 0 if not published */
+    struct _dcid_shm_t *shm;
+    /*! performance counters */
+    dcid_stats_t stats;
+    /*! device offset following the last transfer, for seek accounting */
+    int64_t io_pos;
+    /*! device operation trace, 0 if tracing is disabled */
+    struct _dcid_trace_t *trace;
+    /*! background flush state, 0 until dcid_write_flush_async is first called */
+    struct _dcid_flush_t *flush;
+    /*! XML writer state between dcid_write_begin and dcid_write_end, otherwise 0 */
+    struct _dcid_writer_t *writer;
 }
 dcid_t;
 
@@ -119,10 +484,19 @@ dcid_t;
 
 typedef struct _dcid_info_t
 {
-    int dummy; /*!< temporary placeholder */
+    int write_poll_limit;   /*!< max acknowledge polls per write cycle, 0 for DCID_DEFAULT_WRITE_POLL_LIMIT */
+    int write_timeout_us;   /*!< max write cycle time in microseconds, 0 for DCID_DEFAULT_WRITE_TIMEOUT_US */
+    const char *cache_dir;  /*!< directory for the on-disk cache of decoded card data, 0 to disable */
+    const struct _dcid_backend_t *backend; /*!< device backend (see dcid_backend.h), 0 for the platform default */
 }
 dcid_info_t;
 
+/*! \name DCID write cycle defaults */
+/*! \{ */
+#define DCID_DEFAULT_WRITE_POLL_LIMIT    100     /*!< acknowledge polls per write cycle */
+#define DCID_DEFAULT_WRITE_TIMEOUT_US    10000   /*!< worst case EEPROM write cycle, 10ms */
+/*! \} */
+
 /*! \name DCID sizes, in bytes */
 /*! \{ */
 #define DCID_MAX_XML_SIZE        0x1000  /*!< 4096 bytes, @todo finalize this max */
@@ -132,6 +506,43 @@ dcid_info_t;
 /*! maximum address available for read/write from DCID */
 #define DCID_MAX_ADDRESS (DCID_MAX_RAW_SIZE-1)
 
+/*! size of a record header (16 bit size, followed by 4 character tag) */
+#define DCID_RECORD_HDR_SIZE     6
+/*! maximum record nesting, given that every record carries a header */
+#define DCID_MAX_DEPTH           (DCID_MAX_RAW_SIZE/DCID_RECORD_HDR_SIZE)
+
+/*! 
+
+  @brief DCID record iterator
+
+  This structure walks the records of a DCID image in place. See dcid_iter_begin().
+
+*/
+
+typedef struct _dcid_iter_t
+{
+    /*! image being walked */
+    const uint8_t *image;
+    /*! offset of the current record header */
+    int offset;
+    /*! end offset of the current nesting level */
+    int end;
+    /*! current nesting level, 0 for top level */
+    int depth;
+    /*! header offset of each entered container */
+    uint16_t parent[DCID_MAX_DEPTH];
+
+    /*! current record tag, 4 characters, not null terminated */
+    const char *tag;
+    /*! current record payload */
+    const uint8_t *data;
+    /*! current record payload size, in bytes */
+    int size;
+    /*! non-zero if the current record holds child records */
+    int is_container;
+}
+dcid_iter_t;
+
 /*! \name DCID return codes */
 /*! \{ */
 #define DCID_OK                  0x0000  /*!< Success! */
@@ -141,11 +552,14 @@ dcid_info_t;
 #define DCID_OUT_OF_MEMORY       0x0004  /*!< Out of memory */
 #define DCID_ACCESS_DENIED       0x0005  /*!< Access denied */
 #define DCID_INVALID_CALL        0x0006  /*!< Invalid call */
+#define DCID_BUFFER_TOO_SMALL    0x0007  /*!< Output buffer too small */
+#define DCID_NOT_FOUND           0x0008  /*!< No (more) matching records */
+#define DCID_CANCELLED           0x0009  /*!< Operation cancelled */
 /*! \} */
 
 /*! \name DCID return code lookup table, for convienence */
 /*! \{ */
-char *DCID_RETURN_CODE_LOOKUP[0x07];
+extern char *DCID_RETURN_CODE_LOOKUP[0x0A];
 /*! \} */
 
 /*! \name DCID return code helper functions */
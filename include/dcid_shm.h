@@ -0,0 +1,99 @@
+/*
+ * dcid_shm.h
+ *
+ * dcid contributors
+ * (c) Copyright 2026
+ * All rights reserved
+ *
+ * This API defines a read-only shared memory snapshot of the DCID image and its tag
+ * index. One process (normally dcid --daemon) publishes the snapshot and keeps it current
+ * across writes. Any number of readers map it and look up records without system calls.
+ *
+ * The snapshot carries a generation counter which is odd while an update is in progress.
+ * Readers copy what they need, and retry if the generation changed underneath them.
+ */
+
+#ifndef DCID_SHM_H
+#define DCID_SHM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "dcid_interface.h"
+
+/*! default shared memory segment path */
+#ifndef DCID_SHM_PATH
+#define DCID_SHM_PATH "/dev/shm/dcid"
+#endif
+
+/*! \name forward declarations */
+/*! \{ */
+struct _dcid_shm_t;
+/*! \} */
+
+/*!
+
+ Publish the image of a DCID instance to shared memory. Once published, the snapshot is
+ updated after every flush that writes to the device, until dcid_close. The segment is
+ never reached through a symbolic link, and an existing one must be a plain file belonging
+ to the caller.
+
+  @param p_dcid (INP) - DCID instance
+  @param shm_path (INP) - Segment path, or 0 for DCID_SHM_PATH
+  @return DCID_OK for success, DCID_ACCESS_DENIED if the segment cannot be safely written,
+          otherwise DCID_ error code
+
+ */
+
+int dcid_shm_publish(struct _dcid_t *p_dcid, const char *shm_path);
+
+/*!
+
+ Map a published snapshot, read-only. Only a snapshot published by root (or by the
+ caller) is accepted.
+
+  @param shm_path (INP) - Segment path, or 0 for DCID_SHM_PATH
+  @param pp_shm (OUT) - Pointer to mapped snapshot
+  @return DCID_OK for success, DCID_NOT_FOUND if nothing is published, DCID_ACCESS_DENIED
+          if it was published by another user, otherwise DCID_ error code
+
+ */
+
+int dcid_shm_attach(const char *shm_path, struct _dcid_shm_t **pp_shm);
+
+/*!
+
+ Unmap a snapshot, from either dcid_shm_attach or dcid_shm_publish.
+
+  @param p_shm (INP) - Mapped snapshot
+  @return DCID_OK for success, otherwise DCID_ error code
+
+ */
+
+int dcid_shm_detach(struct _dcid_shm_t *p_shm);
+
+/*!
+
+ Return the current generation of a snapshot. The generation changes whenever the
+ published image does, so readers may keep their own results until it moves.
+
+  @param p_shm (INP) - Mapped snapshot
+  @param p_generation (OUT) - Generation, always even
+  @return DCID_OK for success, otherwise DCID_ error code
+
+ */
+
+int dcid_shm_generation(struct _dcid_shm_t *p_shm, uint32_t *p_generation);
+
+/*! dcid_read_image, answered from a mapped snapshot */
+int dcid_shm_read_image(struct _dcid_shm_t *p_shm, uint8_t *raw_data, int *p_size);
+
+/*! dcid_get, answered from a mapped snapshot */
+int dcid_shm_get(struct _dcid_shm_t *p_shm, const char *path, uint8_t *data, int *p_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,95 @@
+/*
+ * dcid_sim.h
+ *
+ * dcid contributors
+ * (c) Copyright 2026
+ * All rights reserved
+ *
+ * This API defines the simulated DCID backend, used for host builds (CNPLATFORM=sim).
+ * It behaves like a 24C08 EEPROM on an i2c bus, keeps each instance's card contents in
+ * memory (and in the file passed to dcid_init), and models the time each bus transaction
+ * would take. Counters let tests and benchmarks check how much bus traffic an operation
+ * costs without a board.
+ */
+
+#ifndef DCID_SIM_H
+#define DCID_SIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "dcid_backend.h"
+
+/*! size of the simulated device, in bytes */
+#define DCID_SIM_DEVICE_SIZE 0x400
+
+/*! \name DCID simulated bus defaults, modelled on a 24C08 at standard mode */
+/*! \{ */
+#define DCID_SIM_DEFAULT_BUS_HZ          100000  /*!< i2c clock rate */
+#define DCID_SIM_DEFAULT_TRANSACTION_US  50      /*!< fixed cost per transaction (system call, start, stop) */
+#define DCID_SIM_DEFAULT_MAX_READ        0x400   /*!< largest read transaction */
+#define DCID_SIM_DEFAULT_WRITE_PAGE      16      /*!< eeprom write buffer */
+#define DCID_SIM_DEFAULT_WRITE_CYCLE_US  5000    /*!< eeprom write cycle */
+/*! \} */
+
+/*!
+
+  @brief DCID simulated bus settings
+
+  Zero fields take their DCID_SIM_DEFAULT_ values.
+
+*/
+
+typedef struct _dcid_sim_config_t
+{
+    int bus_hz;             /*!< i2c clock rate */
+    int transaction_us;     /*!< fixed cost per transaction, in microseconds */
+    int max_read;           /*!< largest read transaction, in bytes */
+    int write_page;         /*!< eeprom write buffer, in bytes */
+    int write_cycle_us;     /*!< eeprom write cycle, in microseconds */
+    int realtime;           /*!< non-zero to sleep for the modelled time, rather than only count it */
+}
+dcid_sim_config_t;
+
+/*!
+
+  @brief DCID simulated bus counters
+
+*/
+
+typedef struct _dcid_sim_stats_t
+{
+    uint32_t transactions;  /*!< bus transactions (one per backend call) */
+    uint32_t read_bytes;    /*!< data bytes read */
+    uint32_t write_bytes;   /*!< data bytes written */
+    uint32_t write_cycles;  /*!< eeprom write cycles started */
+    uint64_t bus_time_us;   /*!< modelled bus time, including write cycles */
+}
+dcid_sim_stats_t;
+
+/*! simulated 24C08 backend */
+extern dcid_backend_t dcid_backend_sim;
+
+/*!
+
+ Set the simulated bus timing. Affects dcid_backend_sim for all instances.
+
+  @param p_config (INP) - Bus settings, or 0 for defaults
+  @return DCID_OK for success, otherwise DCID_ error code
+
+ */
+
+int dcid_sim_configure(const dcid_sim_config_t *p_config);
+
+/*! read simulated bus counters */
+int dcid_sim_get_stats(dcid_sim_stats_t *p_stats);
+
+/*! reset simulated bus counters */
+int dcid_sim_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,116 @@
+/*
+ * dcid_trace.h
+ *
+ * dcid contributors
+ * (c) Copyright 2026
+ * All rights reserved
+ *
+ * This API defines an optional per-instance trace of device operations. Every operation a
+ * backend performs (one ioctl, one pread, one acknowledge poll, one sleep) is recorded in
+ * a fixed-size ring buffer, with monotonic timestamps. Once the ring is full, the oldest
+ * entries are overwritten.
+ *
+ * Tracing is off unless enabled, and then costs one pointer test per device operation.
+ */
+
+#ifndef DCID_TRACE_H
+#define DCID_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "dcid_interface.h"
+
+#include <stdio.h>
+
+/*! \name forward declarations */
+/*! \{ */
+struct _dcid_trace_t;
+struct _dcid_trace_entry_t;
+/*! \} */
+
+/*! default ring size, in entries */
+#define DCID_TRACE_DEFAULT_ENTRIES 256
+
+/*! \name device operations, as recorded in dcid_trace_entry_t::event */
+/*! \{ */
+#define DCID_IO_READ    0x01    /*!< transfer from the device, size in bytes */
+#define DCID_IO_WRITE   0x02    /*!< transfer to the device, size in bytes */
+#define DCID_IO_POLL    0x03    /*!< write cycle acknowledge poll */
+#define DCID_IO_SLEEP   0x04    /*!< sleep, size in microseconds */
+#define DCID_IO_SYNC    0x05    /*!< commit of buffered writes to stable storage, size in bytes */
+#define DCID_IO_CONTROL 0x06    /*!< device control request, e.g. write protect */
+/*! \} */
+
+/*!
+
+  @brief DCID trace entry
+
+  One device operation.
+
+*/
+
+typedef struct _dcid_trace_entry_t
+{
+    /*! monotonic time at which the operation started, in nanoseconds */
+    uint64_t time_ns;
+    /*! time the operation took, in nanoseconds */
+    uint32_t duration_ns;
+    /*! DCID_IO_ operation */
+    uint8_t event;
+    /*! DCID_ return code of the operation */
+    uint8_t result;
+    /*! size in bytes, or microseconds for DCID_IO_SLEEP */
+    int32_t size;
+    /*! device address, or offset for block devices */
+    int64_t addr;
+    /*! platform primitive used, e.g. "I2C_RDWR" or "pread" */
+    const char *primitive;
+}
+dcid_trace_entry_t;
+
+/*!
+
+ Enable or disable tracing on a DCID instance. Enabling discards anything recorded so far.
+
+  @param p_dcid (INP) - DCID instance
+  @param entries (INP) - Ring size, in entries, or 0 to disable tracing
+  @return DCID_OK for success, otherwise DCID_ error code
+
+ */
+
+int dcid_trace_enable(struct _dcid_t *p_dcid, int entries);
+
+/*!
+
+ Copy recorded entries out of the ring, oldest first.
+
+  @param p_dcid (INP) - DCID instance
+  @param entries (OUT) - Entries
+  @param p_count (INP/OUT) - INP: Max number of entries to write to entries.
+                             OUT: Returns number of entries written. If the buffer is too
+                             small, the newest entries are the ones returned.
+  @return DCID_OK for success, DCID_INVALID_CALL if tracing is disabled, otherwise DCID_ error code
+
+ */
+
+int dcid_trace_read(struct _dcid_t *p_dcid, struct _dcid_trace_entry_t *entries, int *p_count);
+
+/*!
+
+ Print recorded entries as text, oldest first, one line per operation.
+
+  @param p_dcid (INP) - DCID instance
+  @param out (INP) - Output stream
+  @return DCID_OK for success, DCID_INVALID_CALL if tracing is disabled, otherwise DCID_ error code
+
+ */
+
+int dcid_trace_dump(struct _dcid_t *p_dcid, FILE *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,347 @@
+/*
+ * bench-codec.c
+ *
+ * dcid contributors
+ * (c) Copyright 2026
+ * All rights reserved
+ *
+ * This module defines the entry point for the dcid codec benchmark application. It times
+ * XML encoding and image decoding entirely in memory, with no device involved, and writes
+ * one CSV line per measurement. Raw images named on the command line (e.g. saved with
+ * "dcid -o") are measured alongside the synthetic documents.
+ */
+
+#include "dcid_interface.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <time.h>
+
+/*! default minimum time per measurement, in milliseconds */
+#define BENCH_DEFAULT_MIN_MS 200
+
+/*! largest document, in bytes. whitespace padding takes documents well beyond DCID_MAX_XML_SIZE */
+#define BENCH_MAX_DOC (DCID_MAX_XML_SIZE*16)
+
+/*! largest payload of a leaf directly inside the root record, in bytes */
+#define BENCH_MAX_LEAF (0x7F - 2*DCID_RECORD_HDR_SIZE)
+
+/*! leaves in the document used for padding */
+#define BENCH_PAD_LEAVES 12
+
+/*! minimum time per measurement, and fixed iteration count (0 to calibrate) */
+static double bench_min_us = BENCH_DEFAULT_MIN_MS*1000.0;
+static int bench_iterations = 0;
+
+/*! utility function for reading the monotonic clock, in microseconds */
+static double bench_now_us()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec*1000000.0 + ts.tv_nsec/1000.0;
+}
+
+/*! utility function for counting the records of a document, one per opening tag */
+static int doc_records(const char *xml)
+{
+    int records = 0;
+
+    for(;*xml != '\0';xml++)
+    {
+        if(xml[0] == '<' && xml[1] != '/' && xml[1] != '?') { records++; }
+    }
+
+    return records;
+}
+
+/*! utility function for appending pad bytes of whitespace to a document */
+static char *doc_pad(char *xml, int pad)
+{
+    if(pad > 0)
+    {
+        *xml++ = '\n';
+
+        memset(xml, ' ', pad-1);
+
+        xml += pad-1;
+    }
+
+    return xml;
+}
+
+/*! utility function for appending a tag, followed by pad bytes of whitespace */
+static char *doc_tag(char *xml, const char *fmt, int num, int pad)
+{
+    return doc_pad(xml + sprintf(xml, fmt, num), pad);
+}
+
+/*! utility function for appending a leaf record with size bytes of payload */
+static char *doc_leaf(char *xml, const char *tag, int size, int pad)
+{
+    int v;
+
+    xml = doc_tag(xml, tag, 0, pad);
+
+    for(v=0;v<size;v++) { xml += sprintf(xml, "%.02X", (v*37 + 11) & 0xFF); }
+
+    return xml + sprintf(xml, "</%.4s>", tag+1);
+}
+
+/*! build a document of the given shape and size. returns 0 for an unknown shape */
+static int doc_build(char *xml, const char *shape, int size)
+{
+    char *cur = xml;
+    int pad = 0, v;
+
+    if(strcmp(shape, "padded") == 0)
+    {
+        /*! a flat document, with whitespace after every tag bringing it up to size bytes */
+        doc_build(xml, "flat", BENCH_PAD_LEAVES);
+
+        pad = (size - (int)strlen(xml)) / (BENCH_PAD_LEAVES*2 + 2);
+
+        if(pad < 0) { pad = 0; }
+
+        shape = "flat";
+        size = BENCH_PAD_LEAVES;
+    }
+
+    if(strcmp(shape, "flat") == 0)
+    {
+        /*! size leaves of 4 bytes each, inside the root */
+        cur = doc_tag(cur, "<card>", 0, pad);
+
+        for(v=0;v<size;v++)
+        {
+            char tag[16];
+
+            sprintf(tag, "<f%.03d>", v);
+
+            cur = doc_pad(doc_leaf(cur, tag, 4, pad), pad);
+        }
+
+        cur = doc_tag(cur, "</card>", 0, 0);
+    }
+    else if(strcmp(shape, "nested") == 0)
+    {
+        /*! size containers, one inside the other, around a 2 byte leaf */
+        for(v=0;v<size;v++) { cur = doc_tag(cur, "<n%.03d>", v, 0); }
+
+        cur = doc_leaf(cur, "<leaf>", 2, 0);
+
+        for(v=size-1;v>=0;v--) { cur = doc_tag(cur, "</n%.03d>", v, 0); }
+    }
+    else if(strcmp(shape, "leaf") == 0)
+    {
+        /*! one leaf of size bytes, inside the root */
+        cur = doc_tag(cur, "<card>", 0, 0);
+        cur = doc_leaf(cur, "<data>", size, 0);
+        cur = doc_tag(cur, "</card>", 0, 0);
+    }
+    else
+    {
+        return 0;
+    }
+
+    *cur = '\0';
+
+    return 1;
+}
+
+/*! utility function for writing one CSV line */
+static void bench_report(const char *doc, const char *op, int xml_bytes, int raw_bytes, int records, int iterations, double total_us)
+{
+    double ns = total_us*1000.0/iterations;
+
+    printf("%s,%s,%d,%d,%d,%d,%.1f,%.2f,%.1f\n", doc, op, xml_bytes, raw_bytes, records, iterations,
+           ns, (double)xml_bytes*iterations/total_us, ns/records);
+}
+
+/*! time encoding of one document. returns the encoded image */
+static int bench_encode(const char *doc, const char *xml, uint8_t *raw, int *p_raw_size)
+{
+    int xml_size = strlen(xml), records = doc_records(xml);
+    int iterations = 0, ret;
+
+    double beg = bench_now_us(), end = beg;
+
+    do
+    {
+        int size = DCID_MAX_RAW_SIZE;
+
+        ret = dcid_encode_xml(xml, raw, &size);
+
+        if(DCID_FAILED(ret)) { return ret; }
+
+        *p_raw_size = size;
+
+        iterations++;
+
+        /*! check the clock sparingly, so it does not dominate small documents */
+        if((iterations & 0x3F) == 0 || iterations == bench_iterations) { end = bench_now_us(); }
+    }
+    while(bench_iterations > 0 ? iterations < bench_iterations : (end - beg) < bench_min_us);
+
+    end = bench_now_us();
+
+    bench_report(doc, "encode", xml_size, *p_raw_size, records, iterations, end - beg);
+
+    return DCID_OK;
+}
+
+/*! time decoding of one image */
+static int bench_decode(const char *doc, const uint8_t *raw, int raw_size, char *xml)
+{
+    int xml_size = 0, iterations = 0, ret;
+
+    double beg = bench_now_us(), end = beg;
+
+    do
+    {
+        xml_size = BENCH_MAX_DOC;
+
+        ret = dcid_decode_image(raw, raw_size, xml, &xml_size);
+
+        if(DCID_FAILED(ret)) { return ret; }
+
+        iterations++;
+
+        if((iterations & 0x3F) == 0 || iterations == bench_iterations) { end = bench_now_us(); }
+    }
+    while(bench_iterations > 0 ? iterations < bench_iterations : (end - beg) < bench_min_us);
+
+    end = bench_now_us();
+
+    /*! the null terminator is not part of the document */
+    xml_size--;
+
+    bench_report(doc, "decode", xml_size, raw_size, doc_records(xml), iterations, end - beg);
+
+    return DCID_OK;
+}
+
+/*! utility function for loading a raw image from a file */
+static int load_image_file(const char *path, uint8_t *raw, int *p_raw_size)
+{
+    FILE *file = fopen(path, "rb");
+
+    if(file == 0) { return DCID_FAIL; }
+
+    *p_raw_size = fread(raw, 1, DCID_MAX_RAW_SIZE, file);
+
+    fclose(file);
+
+    return (*p_raw_size > 0) ? DCID_OK : DCID_FAIL;
+}
+
+/*! print program usage screen */
+static void show_usage()
+{
+    printf("Usage : bench-codec [-t <MS>] [-n <ITERATIONS>] [IMAGE...]\n");
+    printf("\n");
+    printf("Time in-memory XML encoding and image decoding, one CSV line per measurement.\n");
+    printf("Raw images (e.g. saved with \"dcid -o\") are decoded, and their XML re-encoded.\n");
+    printf("\n");
+    printf("    -t <MS>          Minimum time per measurement (default %d)\n", BENCH_DEFAULT_MIN_MS);
+    printf("    -n <ITERATIONS>  Fixed iterations per measurement, instead of a minimum time\n");
+}
+
+int main(int argc, char **argv)
+{
+    /*! shapes and sizes to measure. padded sizes are in bytes, and run beyond DCID_MAX_XML_SIZE */
+    static const struct { const char *shape; int size; } docs[] =
+    {
+        { "flat", 2 }, { "flat", 6 }, { "flat", 12 },
+        { "nested", 4 }, { "nested", 8 }, { "nested", 16 },
+        { "leaf", 16 }, { "leaf", 64 }, { "leaf", BENCH_MAX_LEAF },
+        { "padded", DCID_MAX_XML_SIZE/4 }, { "padded", DCID_MAX_XML_SIZE },
+        { "padded", DCID_MAX_XML_SIZE*4 }, { "padded", BENCH_MAX_DOC - 1 },
+    };
+
+    /*! default at failure */
+    int main_ret = 1;
+
+    /*! raw image */
+    uint8_t raw[DCID_MAX_RAW_SIZE];
+    int raw_size = 0;
+
+    /*! document and decode buffers */
+    char *xml = (char*)malloc(BENCH_MAX_DOC);
+    char *tmp_buffer = (char*)malloc(BENCH_MAX_DOC);
+
+    int v;
+
+    /*! parse command line, leaving image files in place */
+    for(v=1;v<argc;v++)
+    {
+        if(strcmp(argv[v], "-t") == 0 && v+1 < argc) { bench_min_us = atoi(argv[++v])*1000.0; argv[v-1] = argv[v] = 0; }
+        else if(strcmp(argv[v], "-n") == 0 && v+1 < argc) { bench_iterations = atoi(argv[++v]); argv[v-1] = argv[v] = 0; }
+        else if(argv[v][0] == '-')
+        {
+            show_usage();
+            goto cleanup;
+        }
+    }
+
+    if(bench_iterations < 0) { bench_iterations = 0; }
+    if(bench_min_us <= 0) { bench_min_us = 1; }
+
+    printf("document,operation,xml_bytes,raw_bytes,records,iterations,ns_per_op,mb_per_s,ns_per_record\n");
+
+    /*! synthetic documents */
+    for(v=0;v<(int)(sizeof(docs)/sizeof(docs[0]));v++)
+    {
+        char doc[32];
+
+        sprintf(doc, "%s-%d", docs[v].shape, docs[v].size);
+
+        doc_build(xml, docs[v].shape, docs[v].size);
+
+        int ret = bench_encode(doc, xml, raw, &raw_size);
+
+        if(DCID_SUCCESS(ret)) { ret = bench_decode(doc, raw, raw_size, tmp_buffer); }
+
+        if(DCID_FAILED(ret))
+        {
+            fprintf(stderr, "Error: %s failed (%s)\n", doc, DCID_RETURN_CODE_LOOKUP[ret]);
+            goto cleanup;
+        }
+    }
+
+    /*! raw images */
+    for(v=1;v<argc;v++)
+    {
+        if(argv[v] == 0) { continue; }
+
+        int ret = load_image_file(argv[v], raw, &raw_size);
+
+        if(DCID_FAILED(ret))
+        {
+            fprintf(stderr, "Error: Could not read \"%s\"\n", argv[v]);
+            goto cleanup;
+        }
+
+        ret = bench_decode(argv[v], raw, raw_size, xml);
+
+        if(DCID_SUCCESS(ret)) { ret = bench_encode(argv[v], xml, raw, &raw_size); }
+
+        if(DCID_FAILED(ret))
+        {
+            fprintf(stderr, "Error: %s failed (%s)\n", argv[v], DCID_RETURN_CODE_LOOKUP[ret]);
+            goto cleanup;
+        }
+    }
+
+    main_ret = 0;
+
+cleanup:
+
+    free(xml);
+    free(tmp_buffer);
+
+    return main_ret;
+}
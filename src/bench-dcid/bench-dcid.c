@@ -0,0 +1,586 @@
+/*
+ * bench-dcid.c
+ *
+ * dcid contributors
+ * (c) Copyright 2026
+ * All rights reserved
+ *
+ * This module defines the entry point for the dcid benchmark application. It times the
+ * main DCID operations across documents of different shapes and sizes, and writes one
+ * CSV line per measurement. The card contents are saved first and restored at the end.
+ */
+
+#include "dcid_interface.h"
+#include "dcid_utility.h"
+#include "dcid_backend.h"
+#include "dcid_sim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <time.h>
+
+/*! serial port device path */
+#if defined(CNPLATFORM_falconwing) || defined(CNPLATFORM_silvermoon)
+#define DCID_DEVICE_PATH "/dev/i2c-0"
+#elif defined(CNPLATFORM_sim)
+#define DCID_DEVICE_PATH "dcid-sim.bin"
+#else
+#define DCID_DEVICE_PATH "/dev/dcid"
+#endif
+
+/*! default number of iterations per measurement */
+#define BENCH_DEFAULT_ITERATIONS 5
+
+/*! largest record, in bytes. a document is a single root record, and the 7 bit size
+ *  field (header included) caps it, along with everything inside it */
+#define BENCH_MAX_RECORD 0x7F
+
+/*! largest payload of a leaf directly inside the root record, in bytes */
+#define BENCH_MAX_LEAF (BENCH_MAX_RECORD - 2*DCID_RECORD_HDR_SIZE)
+
+/*! backend being measured, wrapped so that every device transaction is counted */
+static const dcid_backend_t *bench_base = 0;
+static dcid_backend_t bench_backend;
+static uint32_t bench_transactions = 0;
+
+/*! device path and iteration count */
+static const char *bench_device = DCID_DEVICE_PATH;
+static int bench_iterations = BENCH_DEFAULT_ITERATIONS;
+
+/*!
+
+  @brief benchmark counters
+
+  Snapshot of everything measured, taken before and after an operation.
+
+*/
+
+typedef struct _bench_mark_t
+{
+    /*! monotonic time, in microseconds */
+    double wall_us;
+    /*! modelled bus time, in microseconds (simulated backend only) */
+    uint64_t bus_us;
+    /*! backend calls */
+    uint32_t transactions;
+    /*! read and write family system calls */
+    long syscalls;
+}
+bench_mark_t;
+
+/*! system calls made by taking a mark, subtracted from every measurement */
+static long bench_mark_syscalls = 0;
+
+/*! \name counting backend wrappers */
+/*! \{ */
+static int bench_read_block(dcid_t *p_dcid, unsigned int addr, uint8_t *data, int size)
+{
+    bench_transactions++;
+    return bench_base->read_block(p_dcid, addr, data, size);
+}
+
+static int bench_write_block(dcid_t *p_dcid, unsigned int addr, const uint8_t *data, int size)
+{
+    bench_transactions++;
+    return bench_base->write_block(p_dcid, addr, data, size);
+}
+
+static int bench_flush(dcid_t *p_dcid)
+{
+    bench_transactions++;
+    return bench_base->flush(p_dcid);
+}
+/*! \} */
+
+/*! utility function for counting read and write family system calls made so far */
+static long bench_syscalls()
+{
+    char line[128];
+    long total = 0;
+
+    FILE *io = fopen("/proc/self/io", "r");
+
+    if(io == 0) { return 0; }
+
+    while(fgets(line, sizeof(line), io) != 0)
+    {
+        long val = 0;
+
+        if(sscanf(line, "syscr: %ld", &val) == 1 || sscanf(line, "syscw: %ld", &val) == 1) { total += val; }
+    }
+
+    fclose(io);
+
+    return total;
+}
+
+/*! utility function for taking a mark */
+static void bench_mark(bench_mark_t *p_mark)
+{
+    struct timespec ts;
+    dcid_sim_stats_t stats = { 0 };
+
+    p_mark->syscalls = bench_syscalls();
+
+    if(bench_base == &dcid_backend_sim) { dcid_sim_get_stats(&stats); }
+
+    p_mark->bus_us = stats.bus_time_us;
+    p_mark->transactions = bench_transactions;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    p_mark->wall_us = ts.tv_sec*1000000.0 + ts.tv_nsec/1000.0;
+}
+
+/*! utility function for accumulating the difference between two marks */
+static void bench_accumulate(bench_mark_t *p_total, const bench_mark_t *p_beg, const bench_mark_t *p_end)
+{
+    p_total->wall_us += p_end->wall_us - p_beg->wall_us;
+    p_total->bus_us += p_end->bus_us - p_beg->bus_us;
+    p_total->transactions += p_end->transactions - p_beg->transactions;
+    p_total->syscalls += p_end->syscalls - p_beg->syscalls - bench_mark_syscalls;
+}
+
+/*! utility function for writing one CSV line, averaged per iteration */
+static void bench_report(const char *doc, int doc_size, const char *op, const bench_mark_t *p_total, int iterations)
+{
+    printf("%s,%s,%d,%s,%d,%.1f,", bench_base->name, doc, doc_size, op, iterations, p_total->wall_us/iterations);
+
+    if(bench_base == &dcid_backend_sim) { printf("%.1f", (double)p_total->bus_us/iterations); }
+
+    printf(",%.1f,%.1f\n", (double)p_total->transactions/iterations, (double)p_total->syscalls/iterations);
+}
+
+/*! utility function for creating and initializing an instance on the benchmarked backend */
+static int bench_open(dcid_t **pp_dcid)
+{
+    dcid_info_t dcid_info = { 0 };
+
+    dcid_info.backend = &bench_backend;
+
+    int ret = dcid_create(&dcid_info, pp_dcid);
+
+    if(DCID_FAILED(ret)) { return ret; }
+
+    ret = dcid_init(*pp_dcid, (char*)bench_device);
+
+    if(DCID_FAILED(ret)) { dcid_close(*pp_dcid); *pp_dcid = 0; }
+
+    return ret;
+}
+
+/*! utility function for writing a raw image straight to the card */
+static int bench_write_image(const uint8_t *image)
+{
+    dcid_t *p_dcid = 0;
+
+    int size = DCID_MAX_RAW_SIZE;
+
+    int ret = bench_open(&p_dcid);
+
+    if(DCID_SUCCESS(ret)) { ret = dcid_util_write_raw(p_dcid, 0, (uint8_t*)image, &size); }
+    if(DCID_SUCCESS(ret)) { ret = dcid_util_write_flush(p_dcid); }
+
+    if(p_dcid != 0) { dcid_close(p_dcid); }
+
+    return ret;
+}
+
+/*! utility function for appending formatted text to a document */
+static void doc_append(char *xml, const char *text)
+{
+    strcat(xml, text);
+}
+
+/*! utility function for appending a leaf record with size bytes of payload */
+static void doc_leaf(char *xml, const char *tag, int size)
+{
+    char buf[16];
+    int v;
+
+    sprintf(buf, "<%s>", tag);
+    doc_append(xml, buf);
+
+    for(v=0;v<size;v++) { sprintf(buf, "%.02X", (v*37 + 11) & 0xFF); doc_append(xml, buf); }
+
+    sprintf(buf, "</%s>", tag);
+    doc_append(xml, buf);
+}
+
+/*! build a document of the given shape and size, along with the path of its last leaf.
+ *  returns 0 for an unknown shape */
+static int doc_build(char *xml, char *path, const char *shape, int size)
+{
+    char tag[16];
+    int v;
+
+    xml[0] = '\0';
+
+    if(strcmp(shape, "flat") == 0)
+    {
+        /*! size leaves of 4 bytes each, inside the root */
+        doc_append(xml, "<card>");
+
+        for(v=0;v<size;v++) { sprintf(tag, "f%.03d", v); doc_leaf(xml, tag, 4); }
+
+        doc_append(xml, "</card>");
+
+        sprintf(path, "card/f%.03d", size-1);
+    }
+    else if(strcmp(shape, "nested") == 0)
+    {
+        /*! size containers, one inside the other, around a 2 byte leaf */
+        path[0] = '\0';
+
+        for(v=0;v<size;v++)
+        {
+            sprintf(tag, "<n%.03d>", v);
+            doc_append(xml, tag);
+
+            sprintf(tag, "n%.03d/", v);
+            strcat(path, tag);
+        }
+
+        doc_leaf(xml, "leaf", 2);
+
+        strcat(path, "leaf");
+
+        for(v=size-1;v>=0;v--) { sprintf(tag, "</n%.03d>", v); doc_append(xml, tag); }
+    }
+    else if(strcmp(shape, "leaf") == 0)
+    {
+        /*! one leaf of size bytes, inside the root */
+        doc_append(xml, "<card>");
+
+        doc_leaf(xml, "data", size);
+
+        doc_append(xml, "</card>");
+
+        strcpy(path, "card/data");
+    }
+    else
+    {
+        return 0;
+    }
+
+    return 1;
+}
+
+/*! measure every operation for one document */
+static int bench_document(const char *shape, int shape_size, char *xml, const char *path, char *tmp_buffer, uint8_t *blank)
+{
+    bench_mark_t beg, end;
+    bench_mark_t t_write = { 0 }, t_rewrite = { 0 }, t_flush = { 0 }, t_cold = { 0 }, t_warm = { 0 }, t_get = { 0 }, t_cli = { 0 };
+    char doc[32];
+    int it;
+
+    sprintf(doc, "%s-%d", shape, shape_size);
+
+    int xml_size = strlen(xml);
+
+    for(it=0;it<bench_iterations;it++)
+    {
+        dcid_t *p_dcid = 0;
+        int size, ret;
+
+        /*! write_xml onto a blank card, with create/init/close outside the measurement */
+        if(DCID_FAILED(bench_write_image(blank))) { return DCID_FAIL; }
+
+        ret = bench_open(&p_dcid);
+
+        if(DCID_FAILED(ret)) { return ret; }
+
+        strcpy(tmp_buffer, xml);
+
+        size = xml_size;
+
+        bench_mark(&beg);
+        ret = dcid_write_xml(p_dcid, tmp_buffer, &size);
+        bench_mark(&end);
+
+        bench_accumulate(&t_write, &beg, &end);
+
+        /*! write the same document again, which should find nothing to change */
+        if(DCID_SUCCESS(ret))
+        {
+            strcpy(tmp_buffer, xml);
+
+            size = xml_size;
+
+            bench_mark(&beg);
+            ret = dcid_write_xml(p_dcid, tmp_buffer, &size);
+            bench_mark(&end);
+
+            bench_accumulate(&t_rewrite, &beg, &end);
+        }
+
+        /*! read back from memory */
+        if(DCID_SUCCESS(ret))
+        {
+            size = DCID_MAX_XML_SIZE;
+
+            bench_mark(&beg);
+            ret = dcid_read_xml(p_dcid, tmp_buffer, &size);
+            bench_mark(&end);
+
+            bench_accumulate(&t_warm, &beg, &end);
+        }
+
+        dcid_close(p_dcid);
+
+        if(DCID_FAILED(ret)) { fprintf(stderr, "Error: %s write/read failed (%s)\n", doc, DCID_RETURN_CODE_LOOKUP[ret]); return ret; }
+
+        /*! read back on a fresh instance, which has to fetch the image */
+        {
+            ret = bench_open(&p_dcid);
+
+            if(DCID_FAILED(ret)) { return ret; }
+
+            size = DCID_MAX_XML_SIZE;
+
+            bench_mark(&beg);
+            ret = dcid_read_xml(p_dcid, tmp_buffer, &size);
+            bench_mark(&end);
+
+            bench_accumulate(&t_cold, &beg, &end);
+
+            dcid_close(p_dcid);
+
+            if(DCID_FAILED(ret)) { return ret; }
+        }
+
+        /*! look up one record on a fresh instance */
+        {
+            uint8_t data[BENCH_MAX_RECORD];
+
+            ret = bench_open(&p_dcid);
+
+            if(DCID_FAILED(ret)) { return ret; }
+
+            size = sizeof(data);
+
+            bench_mark(&beg);
+            ret = dcid_get(p_dcid, path, data, &size);
+            bench_mark(&end);
+
+            bench_accumulate(&t_get, &beg, &end);
+
+            dcid_close(p_dcid);
+
+            if(DCID_FAILED(ret)) { return ret; }
+        }
+
+        /*! flush alone: stage the encoded image over a blank card, then time the flush */
+        {
+            uint8_t image[DCID_MAX_RAW_SIZE];
+
+            ret = bench_open(&p_dcid);
+
+            size = DCID_MAX_RAW_SIZE;
+
+            if(DCID_SUCCESS(ret)) { ret = dcid_read_image(p_dcid, image, &size); }
+
+            if(p_dcid != 0) { dcid_close(p_dcid); p_dcid = 0; }
+
+            if(DCID_SUCCESS(ret)) { ret = bench_write_image(blank); }
+            if(DCID_SUCCESS(ret)) { ret = bench_open(&p_dcid); }
+
+            size = DCID_MAX_RAW_SIZE;
+
+            if(DCID_SUCCESS(ret)) { ret = dcid_util_write_raw(p_dcid, 0, image, &size); }
+
+            if(DCID_SUCCESS(ret))
+            {
+                bench_mark(&beg);
+                ret = dcid_util_write_flush(p_dcid);
+                bench_mark(&end);
+
+                bench_accumulate(&t_flush, &beg, &end);
+            }
+
+            if(p_dcid != 0) { dcid_close(p_dcid); }
+
+            if(DCID_FAILED(ret)) { return ret; }
+        }
+
+        /*! everything "dcid -w" does: create, init, write, close */
+        {
+            if(DCID_FAILED(bench_write_image(blank))) { return DCID_FAIL; }
+
+            strcpy(tmp_buffer, xml);
+
+            size = xml_size;
+
+            bench_mark(&beg);
+
+            ret = bench_open(&p_dcid);
+
+            if(DCID_SUCCESS(ret)) { ret = dcid_write_xml(p_dcid, tmp_buffer, &size); }
+
+            if(p_dcid != 0) { dcid_close(p_dcid); }
+
+            bench_mark(&end);
+
+            bench_accumulate(&t_cli, &beg, &end);
+
+            if(DCID_FAILED(ret)) { return ret; }
+        }
+    }
+
+    bench_report(doc, xml_size, "write_xml", &t_write, bench_iterations);
+    bench_report(doc, xml_size, "rewrite_xml", &t_rewrite, bench_iterations);
+    bench_report(doc, xml_size, "write_flush", &t_flush, bench_iterations);
+    bench_report(doc, xml_size, "read_xml_cold", &t_cold, bench_iterations);
+    bench_report(doc, xml_size, "read_xml_warm", &t_warm, bench_iterations);
+    bench_report(doc, xml_size, "get_cold", &t_get, bench_iterations);
+    bench_report(doc, xml_size, "cli_write", &t_cli, bench_iterations);
+
+    return DCID_OK;
+}
+
+/*! print program usage screen */
+static void show_usage()
+{
+    printf("Usage : bench-dcid [-d <DEVICE>] [-b <BACKEND>] [-n <ITERATIONS>] [--realtime]\n");
+    printf("\n");
+    printf("Time DCID operations, one CSV line per measurement. Card contents are restored afterwards.\n");
+    printf("\n");
+    printf("    -d <DEVICE>      Device path (default \"%s\")\n", DCID_DEVICE_PATH);
+    printf("    -b <BACKEND>     Backend name, e.g. \"file\" or \"sim\" (default \"%s\")\n", dcid_backend_default()->name);
+    printf("    -n <ITERATIONS>  Iterations per measurement (default %d)\n", BENCH_DEFAULT_ITERATIONS);
+    printf("    --realtime       Simulated backend sleeps for modelled bus time\n");
+}
+
+int main(int argc, char **argv)
+{
+    /*! shapes and sizes to measure */
+    static const struct { const char *shape; int size; } docs[] =
+    {
+        { "flat", 2 }, { "flat", 6 }, { "flat", 12 },
+        { "nested", 4 }, { "nested", 8 }, { "nested", 16 },
+        { "leaf", 16 }, { "leaf", 64 }, { "leaf", BENCH_MAX_LEAF },
+    };
+
+    /*! default at failure */
+    int main_ret = 1;
+
+    /*! card contents to restore */
+    uint8_t saved[DCID_MAX_RAW_SIZE];
+    int saved_valid = 0;
+
+    /*! blank card */
+    uint8_t blank[DCID_MAX_RAW_SIZE];
+
+    /*! path of the record looked up in each document */
+    char path[128];
+
+    /*! document and temporary buffers */
+    char *xml = (char*)malloc(DCID_MAX_XML_SIZE);
+    char *tmp_buffer = (char*)malloc(DCID_MAX_XML_SIZE);
+
+    int realtime = 0, v;
+
+    bench_base = dcid_backend_default();
+
+    /*! parse command line */
+    for(v=1;v<argc;v++)
+    {
+        if(strcmp(argv[v], "-d") == 0 && v+1 < argc) { bench_device = argv[++v]; }
+        else if(strcmp(argv[v], "-n") == 0 && v+1 < argc) { bench_iterations = atoi(argv[++v]); }
+        else if(strcmp(argv[v], "--realtime") == 0) { realtime = 1; }
+        else if(strcmp(argv[v], "-b") == 0 && v+1 < argc)
+        {
+            bench_base = dcid_backend_find(argv[++v]);
+
+            if(bench_base == 0) { fprintf(stderr, "Error: Unknown backend \"%s\"\n", argv[v]); goto cleanup; }
+        }
+        else
+        {
+            show_usage();
+            goto cleanup;
+        }
+    }
+
+    if(bench_iterations <= 0) { bench_iterations = 1; }
+
+    /*! simulated bus timing */
+    {
+        dcid_sim_config_t config = { 0 };
+
+        config.realtime = realtime;
+
+        dcid_sim_configure(&config);
+    }
+
+    /*! wrap backend, so every transaction is counted */
+    bench_backend = *bench_base;
+    bench_backend.read_block = bench_read_block;
+    bench_backend.write_block = bench_write_block;
+    if(bench_base->flush != 0) { bench_backend.flush = bench_flush; }
+
+    /*! calibrate the cost of taking a mark */
+    {
+        bench_mark_t beg, end;
+
+        bench_mark(&beg);
+        bench_mark(&end);
+
+        bench_mark_syscalls = end.syscalls - beg.syscalls;
+    }
+
+    memset(blank, 0, sizeof(blank));
+
+    /*! save card contents */
+    {
+        dcid_t *p_dcid = 0;
+
+        int size = DCID_MAX_RAW_SIZE;
+
+        int ret = bench_open(&p_dcid);
+
+        if(DCID_SUCCESS(ret)) { ret = dcid_read_image(p_dcid, saved, &size); }
+
+        if(p_dcid != 0) { dcid_close(p_dcid); }
+
+        if(DCID_FAILED(ret))
+        {
+            fprintf(stderr, "Error: Could not read \"%s\" (%s)\n", bench_device, DCID_RETURN_CODE_LOOKUP[ret]);
+            goto cleanup;
+        }
+
+        saved_valid = 1;
+    }
+
+    printf("backend,document,xml_bytes,operation,iterations,wall_us,bus_us,transactions,syscalls\n");
+
+    for(v=0;v<(int)(sizeof(docs)/sizeof(docs[0]));v++)
+    {
+        doc_build(xml, path, docs[v].shape, docs[v].size);
+
+        int ret = bench_document(docs[v].shape, docs[v].size, xml, path, tmp_buffer, blank);
+
+        if(DCID_FAILED(ret))
+        {
+            fprintf(stderr, "Error: %s-%d failed (%s)\n", docs[v].shape, docs[v].size, DCID_RETURN_CODE_LOOKUP[ret]);
+            goto cleanup;
+        }
+    }
+
+    main_ret = 0;
+
+cleanup:
+
+    /*! put the card back the way we found it */
+    if(saved_valid && DCID_FAILED(bench_write_image(saved)))
+    {
+        fprintf(stderr, "Error: Could not restore \"%s\"\n", bench_device);
+        main_ret = 1;
+    }
+
+    free(xml);
+    free(tmp_buffer);
+
+    return main_ret;
+}
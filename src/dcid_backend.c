@@ -0,0 +1,86 @@
+/*
+ * dcid_backend.c
+ *
+ * dcid contributors
+ * (c) Copyright 2026
+ * All rights reserved
+ *
+ * This module implements backend selection, and helpers shared between backends.
+ */
+
+#include "dcid_backend.h"
+#include "dcid_utility.h"
+#include "dcid_sim.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+/*! all backends, for lookup by name */
+static const dcid_backend_t *backend_list[] =
+{
+    &dcid_backend_falconwing,
+    &dcid_backend_silvermoon,
+    &dcid_backend_ironforge,
+    &dcid_backend_emmc,
+    &dcid_backend_emmc_direct,
+    &dcid_backend_emmc_nosync,
+    &dcid_backend_file,
+    &dcid_backend_mmap,
+    &dcid_backend_mmap_nosync,
+    &dcid_backend_sim,
+};
+
+const dcid_backend_t *dcid_backend_default(void)
+{
+#if defined(CNPLATFORM_falconwing)
+    return &dcid_backend_falconwing;
+#elif defined(CNPLATFORM_silvermoon)
+    return &dcid_backend_silvermoon;
+#elif defined(CNPLATFORM_netv) || defined(CNPLATFORM_wintergrasp)
+    return &dcid_backend_emmc;
+#elif defined(CNPLATFORM_avlite)
+    return &dcid_backend_mmap;
+#elif defined(CNPLATFORM_sim)
+    return &dcid_backend_sim;
+#else
+    return &dcid_backend_ironforge;
+#endif
+}
+
+const dcid_backend_t *dcid_backend_find(const char *name)
+{
+    int v;
+
+    if(name == 0) { return 0; }
+
+    for(v=0;v<(int)(sizeof(backend_list)/sizeof(backend_list[0]));v++)
+    {
+        if(strcmp(backend_list[v]->name, name) == 0) { return backend_list[v]; }
+    }
+
+    return 0;
+}
+
+int dcid_backend_open_device(dcid_t *p_dcid, const char *path)
+{
+    /*! attempt to open dcid device */
+    p_dcid->device_file = open(path, O_RDWR);
+
+    /*! failed to open dcid device */
+    if(p_dcid->device_file == -1) { return DCID_FAIL; }
+
+    return DCID_OK;
+}
+
+int dcid_backend_close_device(dcid_t *p_dcid)
+{
+    /*! close device device file */
+    if(p_dcid->device_file != -1)
+    {
+        close(p_dcid->device_file);
+        p_dcid->device_file = -1;
+    }
+
+    return DCID_OK;
+}
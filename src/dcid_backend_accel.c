@@ -0,0 +1,196 @@
+/*
+ * dcid_backend_accel.c
+ *
+ * dcid contributors
+ * (c) Copyright 2026
+ * All rights reserved
+ *
+ * This module implements the backend for the SPI EEPROM behind the chumby_accel driver
+ * (ironforge). Blocks move with one bulk ioctl each, or one ioctl per byte on drivers
+ * which predate the bulk commands. A flush runs inside a single UNLOCKROM/LOCKROM window.
+ *
+ * The ACCEL_IOCTL ROM access comes from dcid_utility.c (Chumby Industries, 2007).
+ */
+
+#include "dcid_accel.h"
+#include "dcid_utility.h"
+#include "chumby_accel.h" // @note this should be imported at some point!
+
+#include <string.h>
+#include <malloc.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+
+/*! per instance state, kept in dcid_t::backend_data */
+typedef struct _accel_state_t
+{
+    /*! non-zero until the driver turns down a bulk command */
+    int bulk;
+    /*! non-zero between prepare and flush */
+    int unlocked;
+}
+accel_state_t;
+
+/*! default handler */
+static int accel_sys_ioctl(int fd, unsigned long request, void *arg)
+{
+    return ioctl(fd, request, arg);
+}
+
+static dcid_accel_ioctl_t accel_ioctl = accel_sys_ioctl;
+
+/*! utility function for issuing one request, accounted as a device operation */
+static int accel_request(dcid_t *p_dcid, unsigned long request, void *arg, int event, unsigned int addr, int size, const char *primitive)
+{
+    uint64_t beg = DCID_IO_BEGIN(p_dcid);
+
+    int ret = (accel_ioctl(p_dcid->device_file, request, arg) != 0) ? DCID_FAIL : DCID_OK;
+
+    /*! keep errno for the caller, past the accounting */
+    int err = errno;
+
+    dcid_util_io(p_dcid, event, addr, size, primitive, beg, ret);
+
+    errno = err;
+
+    return ret;
+}
+
+/*! utility function for issuing a bulk request. returns DCID_NOT_FOUND if the driver does not have it */
+static int accel_bulk(dcid_t *p_dcid, unsigned long request, unsigned int addr, uint8_t *data, int size, int event, const char *primitive)
+{
+    accel_state_t *p_state = (accel_state_t*)p_dcid->backend_data;
+
+    struct eeprom_bulk_data bd = { .address = addr, .length = size, .data = data };
+
+    if(!p_state->bulk) { return DCID_NOT_FOUND; }
+
+    int ret = accel_request(p_dcid, request, &bd, event, addr, size, primitive);
+
+    /*! older drivers reject the command outright, and are not asked again */
+    if(DCID_FAILED(ret) && (errno == ENOTTY || errno == EINVAL))
+    {
+        p_state->bulk = 0;
+        return DCID_NOT_FOUND;
+    }
+
+    return ret;
+}
+
+static int accel_open(dcid_t *p_dcid, const char *path)
+{
+    accel_state_t *p_state;
+
+    if(DCID_FAILED(dcid_backend_open_device(p_dcid, path))) { return DCID_FAIL; }
+
+    p_state = (accel_state_t*)malloc(sizeof(accel_state_t));
+
+    if(p_state == 0)
+    {
+        dcid_backend_close_device(p_dcid);
+        return DCID_OUT_OF_MEMORY;
+    }
+
+    p_state->bulk = 1;
+    p_state->unlocked = 0;
+
+    p_dcid->backend_data = p_state;
+
+    return DCID_OK;
+}
+
+static int accel_read_block(dcid_t *p_dcid, unsigned int addr, uint8_t *data, int size)
+{
+    int ret = accel_bulk(p_dcid, ACCEL_IOCTL_READROM_BULK, addr, data, size, DCID_IO_READ, "READROM_BULK");
+    int v;
+
+    if(ret != DCID_NOT_FOUND) { return ret; }
+
+    for(v=0;v<size;v++)
+    {
+        struct eeprom_data ed = { .address = addr + v, .data = 0 };
+
+        ret = accel_request(p_dcid, ACCEL_IOCTL_READROM, &ed, DCID_IO_READ, addr + v, 1, "READROM");
+
+        if(DCID_FAILED(ret)) { return ret; }
+
+        data[v] = ed.data;
+    }
+
+    return DCID_OK;
+}
+
+static int accel_write_block(dcid_t *p_dcid, unsigned int addr, const uint8_t *data, int size)
+{
+    /*! the driver only reads from the buffer */
+    int ret = accel_bulk(p_dcid, ACCEL_IOCTL_SETROM_BULK, addr, (uint8_t*)data, size, DCID_IO_WRITE, "SETROM_BULK");
+    int v;
+
+    if(ret != DCID_NOT_FOUND) { return ret; }
+
+    for(v=0;v<size;v++)
+    {
+        struct eeprom_data ed = { .address = addr + v, .data = data[v] };
+
+        ret = accel_request(p_dcid, ACCEL_IOCTL_SETROM, &ed, DCID_IO_WRITE, addr + v, 1, "SETROM");
+
+        if(DCID_FAILED(ret)) { return ret; }
+    }
+
+    return DCID_OK;
+}
+
+/*! lift write protection once for the whole flush */
+static int accel_prepare(dcid_t *p_dcid)
+{
+    accel_state_t *p_state = (accel_state_t*)p_dcid->backend_data;
+
+    int ret = accel_request(p_dcid, ACCEL_IOCTL_UNLOCKROM, 0, DCID_IO_CONTROL, 0, 0, "UNLOCKROM");
+
+    if(DCID_SUCCESS(ret)) { p_state->unlocked = 1; }
+
+    return ret;
+}
+
+/*! restore write protection, if prepare lifted it */
+static int accel_flush(dcid_t *p_dcid)
+{
+    accel_state_t *p_state = (accel_state_t*)p_dcid->backend_data;
+
+    if(!p_state->unlocked) { return DCID_OK; }
+
+    p_state->unlocked = 0;
+
+    return accel_request(p_dcid, ACCEL_IOCTL_LOCKROM, 0, DCID_IO_CONTROL, 0, 0, "LOCKROM");
+}
+
+static int accel_close(dcid_t *p_dcid)
+{
+    if(p_dcid->backend_data != 0)
+    {
+        free(p_dcid->backend_data);
+        p_dcid->backend_data = 0;
+    }
+
+    return dcid_backend_close_device(p_dcid);
+}
+
+int dcid_accel_set_ioctl(dcid_accel_ioctl_t handler)
+{
+    accel_ioctl = (handler != 0) ? handler : accel_sys_ioctl;
+
+    return DCID_OK;
+}
+
+const dcid_backend_t dcid_backend_ironforge =
+{
+    "ironforge",
+    { DCID_MAX_RAW_SIZE + DCID_IDENT_SIZE, DCID_MAX_RAW_SIZE, 0 },
+    0,
+    accel_open,
+    accel_read_block,
+    accel_prepare,
+    accel_write_block,
+    accel_flush,
+    accel_close,
+};
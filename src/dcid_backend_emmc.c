@@ -0,0 +1,383 @@
+/*
+ * dcid_backend_emmc.c
+ *
+ * dcid contributors
+ * (c) Copyright 2026
+ * All rights reserved
+ *
+ * This module implements the backend for the "dcid" block of the eMMC config area
+ * (netv, wintergrasp).
+ *
+ * locate_config_block grew out of seek_config_block in dcid_utility.c (Chumby Industries, 2007).
+ */
+
+#define _GNU_SOURCE /* pread, pwrite */
+
+#include "dcid_backend.h"
+#include "dcid_utility.h"
+
+#include <string.h>
+#include <malloc.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+
+/*************************************************************************/
+#define ESD_CONFIG_AREA_PART1_OFFSET    0xc000
+// pragma pack() not supported on all platforms, so we make everything dword-aligned using arrays
+// WARNING: we're being lazy here and assuming that the platform any utility using this
+// is running on little-endian! Otherwise you'll need to convert u32 values
+typedef union {
+        char name[4];
+        unsigned int uname;
+} block_def_name;
+
+typedef struct _block_def {
+        unsigned int offset;            // Offset from start of partition 1; if 0xffffffff, end of block table
+        unsigned int length;            // Length of block in bytes
+        unsigned char block_ver[4];     // Version of this block data, e.g. 1,0,0,0
+        block_def_name n;               // Name of block, e.g. "krnA" (not NULL-terminated, a-z, A-Z, 0-9 and non-escape symbols allowed)
+} block_def;
+
+typedef struct _config_area {
+        char sig[4];    // 'C','f','g','*'
+        unsigned char area_version[4];  // 1,0,0,0
+        unsigned char active_index[4];  // element 0 is 0 if krnA active, 1 if krnB; elements 1-3 are padding
+        unsigned char updating[4];      // element 0 is 1 if update in progress; elements 1-3 are padding
+        char last_update[16];           // NULL-terminated version of last successful update, e.g. "1.7.1892"
+        unsigned int p1_offset;         // Offset in bytes from start of device to start of partition 1
+        char factory_data[220];         // Data recorded in manufacturing in format KEY=VALUE<newline>...
+        char configname[128];           // NULL-terminated CONFIGNAME of current build, e.g. "silvermoon_sd"
+        unsigned char unused2[128];
+        unsigned char mbr_backup[512];  // Backup copy of MBR
+        block_def block_table[64];      // Block table entries ending with offset==0xffffffff
+        unsigned char unused3[0];
+} config_area;
+
+/*************************************************************************/
+/*! sector size assumed when the device does not report one */
+#define DCID_EMMC_SECTOR_SIZE   512
+/*! alignment of the staging buffer, and largest sector size supported */
+#define DCID_EMMC_BUFFER_ALIGN  4096
+/*! staging buffer size: sectors covering the image, wherever it starts within a sector */
+#define DCID_EMMC_BUFFER_SIZE   (((DCID_MAX_RAW_SIZE + DCID_EMMC_BUFFER_ALIGN - 1) / DCID_EMMC_BUFFER_ALIGN + 1) * DCID_EMMC_BUFFER_ALIGN)
+
+/*! settings for one flavour of the backend */
+typedef struct _emmc_config_t {
+        int sync;       // fdatasync after each flush
+        int direct;     // bypass the page cache (O_DIRECT) for read-modify-write
+} emmc_config_t;
+
+static const emmc_config_t emmc_default_config = { 1, 0 };
+static const emmc_config_t emmc_direct_config = { 1, 1 };
+static const emmc_config_t emmc_nosync_config = { 0, 0 };
+
+/*! per instance state, kept in dcid_t::backend_data. writes are applied to a copy of the
+ *  sectors covering the dcid block, which go back to the device in one piece on flush */
+typedef struct _emmc_state_t {
+        int sector_size;        // logical sector size of the device
+        uint8_t *buf;           // sector aligned staging buffer, covering the image
+        int64_t buf_offset;     // device offset of buf, sector aligned
+        int buf_len;            // bytes in buf, a multiple of sector_size
+        int loaded;             // set once buf holds the device sectors for this flush
+        int dirty_beg;          // range of buf written since loaded, empty if dirty_end is 0
+        int dirty_end;
+} emmc_state_t;
+
+/* pread, accounted as a device operation. returns 1 if the whole block was read */
+static int emmc_pread(dcid_t *p_dcid, void *data, int size, int64_t offset) {
+    uint64_t beg = DCID_IO_BEGIN(p_dcid);
+    int ok;
+
+    dcid_util_io_seek(p_dcid, offset);
+    ok = (size == pread(p_dcid->device_file, data, size, offset));
+    dcid_util_io(p_dcid, DCID_IO_READ, offset, size, "pread", beg, ok ? DCID_OK : DCID_FAIL);
+
+    return ok;
+}
+
+/* pwrite, accounted as a device operation. returns 1 if the whole block was written */
+static int emmc_pwrite(dcid_t *p_dcid, const void *data, int size, int64_t offset) {
+    uint64_t beg = DCID_IO_BEGIN(p_dcid);
+    int ok;
+
+    dcid_util_io_seek(p_dcid, offset);
+    ok = (size == pwrite(p_dcid->device_file, data, size, offset));
+    dcid_util_io(p_dcid, DCID_IO_WRITE, offset, size, "pwrite", beg, ok ? DCID_OK : DCID_FAIL);
+
+    return ok;
+}
+
+/*! locate the named block in the config area, and remember its offset. if a block offset is
+ *  already known, it is reused as long as the config area signature has not changed. */
+static int locate_config_block(dcid_t *p_dcid, char *name, int verify) {
+    int block;
+    config_area cfg;
+
+    if (p_dcid->device_file == -1) {
+        perror("Unable to open config block device");
+        return 0;
+    }
+
+    if (p_dcid->block_offset != -1) {
+        char sig[4];
+
+        if (!verify)
+            return 1;
+
+        /* Check that the config area has not been rewritten */
+        if (!emmc_pread(p_dcid, sig, sizeof(sig), ESD_CONFIG_AREA_PART1_OFFSET)) {
+            perror("Unable to read config area");
+            return 0;
+        }
+
+        if (!memcmp(sig, p_dcid->block_sig, sizeof(sig)))
+            return 1;
+
+        p_dcid->block_offset = -1;
+    }
+
+    /* Read config table */
+    if (!emmc_pread(p_dcid, &cfg, sizeof(cfg), ESD_CONFIG_AREA_PART1_OFFSET)) {
+        perror("Unable to read config area");
+        goto out;
+    }
+
+    /* Locate cpid block */
+    for (block=0; block < sizeof(cfg.block_table) / sizeof(cfg.block_table[0]); block++) {
+        if (!memcmp(cfg.block_table[block].n.name, name, 4)) {
+
+            /* Remember specified block */
+            p_dcid->block_offset = cfg.block_table[block].offset;
+            memcpy(p_dcid->block_sig, cfg.sig, sizeof(cfg.sig));
+
+            return 1;
+        }
+    }
+
+out:
+    return 0;
+}
+
+static int emmc_read_block(dcid_t *p_dcid, unsigned int addr, uint8_t *data, int size)
+{
+    if (!locate_config_block(p_dcid, "dcid", 1))
+        return DCID_FAIL;
+    if (!emmc_pread(p_dcid, data, size, p_dcid->block_offset + addr)) {
+        perror("Unable to read");
+        return DCID_FAIL;
+    }
+    return DCID_OK;
+}
+
+/* enable or disable O_DIRECT on the device file, for the direct flavour only */
+static int emmc_set_direct(dcid_t *p_dcid, int enable) {
+    const emmc_config_t *p_config = (const emmc_config_t*)p_dcid->backend->config;
+    int flags;
+
+    if (!p_config->direct)
+        return 1;
+
+    flags = fcntl(p_dcid->device_file, F_GETFL);
+    if (flags == -1)
+        return 0;
+
+    flags = enable ? (flags | O_DIRECT) : (flags & ~O_DIRECT);
+
+    return fcntl(p_dcid->device_file, F_SETFL, flags) == 0;
+}
+
+/* read the sectors covering the dcid block into the staging buffer, with one aligned pread */
+static int emmc_load_sectors(dcid_t *p_dcid) {
+    emmc_state_t *p_state = (emmc_state_t*)p_dcid->backend_data;
+    int64_t beg, end;
+    int ok;
+
+    if (!locate_config_block(p_dcid, "dcid", 1))
+        return DCID_FAIL;
+
+    beg = p_dcid->block_offset - (p_dcid->block_offset % p_state->sector_size);
+    end = p_dcid->block_offset + DCID_MAX_RAW_SIZE;
+    end = ((end + p_state->sector_size - 1) / p_state->sector_size) * p_state->sector_size;
+
+    if (end - beg > DCID_EMMC_BUFFER_SIZE)
+        return DCID_FAIL;
+
+    p_state->buf_offset = beg;
+    p_state->buf_len = (int)(end - beg);
+
+    if (!emmc_set_direct(p_dcid, 1)) {
+        perror("Unable to enable O_DIRECT");
+        return DCID_FAIL;
+    }
+    ok = emmc_pread(p_dcid, p_state->buf, p_state->buf_len, p_state->buf_offset);
+    emmc_set_direct(p_dcid, 0);
+
+    if (!ok) {
+        perror("Unable to read");
+        return DCID_FAIL;
+    }
+
+    p_state->loaded = 1;
+    p_state->dirty_beg = p_state->dirty_end = 0;
+
+    return DCID_OK;
+}
+
+/* apply a write to the staging buffer. nothing reaches the device until emmc_flush */
+static int emmc_write_block(dcid_t *p_dcid, unsigned int addr, const uint8_t *data, int size)
+{
+    emmc_state_t *p_state = (emmc_state_t*)p_dcid->backend_data;
+    int pos;
+
+    if (addr + size > DCID_MAX_RAW_SIZE)
+        return DCID_INVALID_PARAM;
+
+    if (!p_state->loaded) {
+        int ret = emmc_load_sectors(p_dcid);
+        if (DCID_FAILED(ret))
+            return ret;
+    }
+
+    pos = (int)(p_dcid->block_offset + addr - p_state->buf_offset);
+
+    memcpy(&p_state->buf[pos], data, size);
+
+    if (p_state->dirty_end == 0 || pos < p_state->dirty_beg)
+        p_state->dirty_beg = pos;
+    if (pos + size > p_state->dirty_end)
+        p_state->dirty_end = pos + size;
+
+    return DCID_OK;
+}
+
+/* write the dirty sectors back with one aligned pwrite, then optionally fdatasync */
+static int emmc_flush(dcid_t *p_dcid)
+{
+    const emmc_config_t *p_config = (const emmc_config_t*)p_dcid->backend->config;
+    emmc_state_t *p_state = (emmc_state_t*)p_dcid->backend_data;
+    int beg, end, ok;
+
+    /* the next flush reads the device afresh, in case anyone else wrote to it */
+    p_state->loaded = 0;
+
+    if (p_state->dirty_end == 0)
+        return DCID_OK;
+
+    beg = p_state->dirty_beg - (p_state->dirty_beg % p_state->sector_size);
+    end = ((p_state->dirty_end + p_state->sector_size - 1) / p_state->sector_size) * p_state->sector_size;
+
+    p_state->dirty_beg = p_state->dirty_end = 0;
+
+    if (!emmc_set_direct(p_dcid, 1)) {
+        perror("Unable to enable O_DIRECT");
+        return DCID_FAIL;
+    }
+    ok = emmc_pwrite(p_dcid, &p_state->buf[beg], end - beg, p_state->buf_offset + beg);
+    emmc_set_direct(p_dcid, 0);
+
+    if (!ok) {
+        perror("Unable to write");
+        return DCID_FAIL;
+    }
+
+    if (p_config->sync) {
+        uint64_t start = DCID_IO_BEGIN(p_dcid);
+        int ret = (fdatasync(p_dcid->device_file) == 0) ? DCID_OK : DCID_FAIL;
+
+        dcid_util_io(p_dcid, DCID_IO_SYNC, p_state->buf_offset + beg, end - beg, "fdatasync", start, ret);
+
+        if (DCID_FAILED(ret)) {
+            perror("Unable to sync");
+            return DCID_FAIL;
+        }
+    }
+
+    return DCID_OK;
+}
+
+static int emmc_open(dcid_t *p_dcid, const char *path)
+{
+    emmc_state_t *p_state;
+    void *buf = 0;
+    int sector_size = 0;
+
+    if (DCID_FAILED(dcid_backend_open_device(p_dcid, path)))
+        return DCID_FAIL;
+
+    /* regular files (and devices which do not say) get the usual 512 byte sector */
+    if (ioctl(p_dcid->device_file, BLKSSZGET, &sector_size) != 0 || sector_size < DCID_EMMC_SECTOR_SIZE || sector_size > DCID_EMMC_BUFFER_ALIGN)
+        sector_size = DCID_EMMC_SECTOR_SIZE;
+
+    p_state = (emmc_state_t*)malloc(sizeof(emmc_state_t));
+
+    if (p_state == 0 || posix_memalign(&buf, DCID_EMMC_BUFFER_ALIGN, DCID_EMMC_BUFFER_SIZE) != 0) {
+        free(p_state);
+        dcid_backend_close_device(p_dcid);
+        return DCID_OUT_OF_MEMORY;
+    }
+
+    memset(p_state, 0, sizeof(emmc_state_t));
+
+    p_state->sector_size = sector_size;
+    p_state->buf = (uint8_t*)buf;
+
+    p_dcid->backend_data = p_state;
+
+    return DCID_OK;
+}
+
+static int emmc_close(dcid_t *p_dcid)
+{
+    emmc_state_t *p_state = (emmc_state_t*)p_dcid->backend_data;
+
+    if (p_state != 0) {
+        free(p_state->buf);
+        free(p_state);
+        p_dcid->backend_data = 0;
+    }
+
+    return dcid_backend_close_device(p_dcid);
+}
+
+const dcid_backend_t dcid_backend_emmc =
+{
+    "emmc",
+    { DCID_MAX_RAW_SIZE + DCID_IDENT_SIZE, DCID_MAX_RAW_SIZE, 0 },
+    &emmc_default_config,
+    emmc_open,
+    emmc_read_block,
+    0,
+    emmc_write_block,
+    emmc_flush,
+    emmc_close,
+};
+
+const dcid_backend_t dcid_backend_emmc_direct =
+{
+    "emmc-direct",
+    { DCID_MAX_RAW_SIZE + DCID_IDENT_SIZE, DCID_MAX_RAW_SIZE, 0 },
+    &emmc_direct_config,
+    emmc_open,
+    emmc_read_block,
+    0,
+    emmc_write_block,
+    emmc_flush,
+    emmc_close,
+};
+
+const dcid_backend_t dcid_backend_emmc_nosync =
+{
+    "emmc-nosync",
+    { DCID_MAX_RAW_SIZE + DCID_IDENT_SIZE, DCID_MAX_RAW_SIZE, 0 },
+    &emmc_nosync_config,
+    emmc_open,
+    emmc_read_block,
+    0,
+    emmc_write_block,
+    emmc_flush,
+    emmc_close,
+};
@@ -0,0 +1,89 @@
+/*
+ * dcid_backend_file.c
+ *
+ * dcid contributors
+ * (c) Copyright 2026
+ * All rights reserved
+ *
+ * This module implements the backend for a card image kept in a plain file (avlite).
+ *
+ * The lseek based file access comes from dcid_utility.c (Chumby Industries, 2007).
+ */
+
+#define _GNU_SOURCE /* pread, pwrite */
+
+#include "dcid_backend.h"
+#include "dcid_utility.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdio.h>
+
+/*! size of a newly created image file, in bytes */
+#define DCID_FILE_CREATE_SIZE 2048
+
+/*! open image file, creating a blank one if it does not exist yet */
+static int file_open(dcid_t *p_dcid, const char *path)
+{
+    if(DCID_SUCCESS(dcid_backend_open_device(p_dcid, path))) { return DCID_OK; }
+
+    p_dcid->device_file = open(path, O_RDWR | O_CREAT, 0644);
+
+    if(p_dcid->device_file == -1) { return DCID_FAIL; }
+
+    {
+        char data[DCID_FILE_CREATE_SIZE];
+        memset(data, 0, sizeof(data));
+        if(sizeof(data) != write(p_dcid->device_file, data, sizeof(data))) {
+            perror("Unable to write");
+        }
+    }
+
+    return DCID_OK;
+}
+
+static int file_read_block(dcid_t *p_dcid, unsigned int addr, uint8_t *data, int size)
+{
+    uint64_t beg = DCID_IO_BEGIN(p_dcid);
+    int ret;
+
+    dcid_util_io_seek(p_dcid, addr);
+    ret = (size == pread(p_dcid->device_file, data, size, addr)) ? DCID_OK : DCID_FAIL;
+    dcid_util_io(p_dcid, DCID_IO_READ, addr, size, "pread", beg, ret);
+
+    if(DCID_FAILED(ret)) {
+        perror("Unable to read");
+        return DCID_FAIL;
+    }
+    return DCID_OK;
+}
+
+static int file_write_block(dcid_t *p_dcid, unsigned int addr, const uint8_t *data, int size)
+{
+    uint64_t beg = DCID_IO_BEGIN(p_dcid);
+    int ret;
+
+    dcid_util_io_seek(p_dcid, addr);
+    ret = (size == pwrite(p_dcid->device_file, data, size, addr)) ? DCID_OK : DCID_FAIL;
+    dcid_util_io(p_dcid, DCID_IO_WRITE, addr, size, "pwrite", beg, ret);
+
+    if(DCID_FAILED(ret)) {
+        perror("Unable to write");
+        return DCID_FAIL;
+    }
+    return DCID_OK;
+}
+
+const dcid_backend_t dcid_backend_file =
+{
+    "file",
+    { DCID_FILE_CREATE_SIZE, DCID_MAX_RAW_SIZE, 0 },
+    0,
+    file_open,
+    file_read_block,
+    0,
+    file_write_block,
+    0,
+    dcid_backend_close_device,
+};
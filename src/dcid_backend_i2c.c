@@ -0,0 +1,228 @@
+/*
+ * dcid_backend_i2c.c
+ *
+ * dcid contributors
+ * (c) Copyright 2026
+ * All rights reserved
+ *
+ * This module implements the backend for a 24C08 EEPROM on an i2c bus (falconwing,
+ * silvermoon).
+ *
+ * The I2C_RDWR transfers come from dcid_utility.c (Chumby Industries, 2007).
+ */
+
+#include "dcid_backend.h"
+#include "dcid_utility.h"
+
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include <sys/ioctl.h>
+#include <sys/time.h>
+#include <stdio.h>
+#include <unistd.h>
+
+/*! number of 256 byte pages which are addressable through the i2c address */
+#define DCID_EEPROM_PAGES 4
+/*! size of the eeprom write buffer. page writes must not cross a multiple of this size */
+#define DCID_EEPROM_WRITE_PAGE 16
+/*! typical eeprom write cycle, in microseconds */
+#define DCID_EEPROM_WRITE_CYCLE_US 5000
+/*! delay between acknowledge polls, in microseconds */
+#define DCID_EEPROM_POLL_DELAY_US 100
+
+/*! bus settings for one board */
+typedef struct _i2c_config_t
+{
+    /*! i2c address of the first 256 byte page */
+    int eeprom_addr;
+    /*! i2c address step between pages */
+    int page_multiplier;
+}
+i2c_config_t;
+
+static const i2c_config_t falconwing_config = { 0xA8, 2 };
+static const i2c_config_t silvermoon_config = { 0x50, 1 };
+
+/*! i2c address of the page holding addr */
+#define I2C_PAGE_ADDR(p_config, page) ((p_config)->eeprom_addr + ((page)*(p_config)->page_multiplier))
+
+/*! read a block of bytes using a single I2C_RDWR transaction. each 256 byte page
+ *  touched by the block costs one address write and one read message. */
+static int i2c_read_block(dcid_t *p_dcid, unsigned int addr, uint8_t *raw_data, int size)
+{
+    const i2c_config_t *p_config = (const i2c_config_t*)p_dcid->backend->config;
+    unsigned char output[DCID_EEPROM_PAGES];
+    struct i2c_rdwr_ioctl_data packets;
+    struct i2c_msg messages[DCID_EEPROM_PAGES*2];
+    int nmsgs = 0;
+    int done = 0;
+
+    while(done < size)
+    {
+        unsigned int cur = addr + done;
+        int byte = (cur   ) & 0xff;
+        int page = (cur>>8) & 0x03;
+        int len = 256 - byte;
+
+        if(len > size - done) { len = size - done; }
+
+        /*! never wrap around the device */
+        if(nmsgs >= DCID_EEPROM_PAGES*2) { return DCID_FAIL; }
+
+        output[nmsgs/2] = byte;
+
+        messages[nmsgs].addr    = I2C_PAGE_ADDR(p_config, page);
+        messages[nmsgs].flags   = 0;
+        messages[nmsgs].len     = 1;
+        messages[nmsgs].buf     = &output[nmsgs/2];
+        nmsgs++;
+
+        messages[nmsgs].addr    = I2C_PAGE_ADDR(p_config, page);
+        messages[nmsgs].flags   = I2C_M_RD;
+        messages[nmsgs].len     = len;
+        messages[nmsgs].buf     = &raw_data[done];
+        nmsgs++;
+
+        done += len;
+    }
+
+    packets.msgs    = messages;
+    packets.nmsgs   = nmsgs;
+
+    {
+        uint64_t beg = DCID_IO_BEGIN(p_dcid);
+
+        int ret = (ioctl(p_dcid->device_file, I2C_RDWR, &packets) < 0) ? DCID_FAIL : DCID_OK;
+
+        dcid_util_io(p_dcid, DCID_IO_READ, addr, size, "I2C_RDWR", beg, ret);
+
+        if(DCID_FAILED(ret)) {
+            perror("Failure");
+            return DCID_FAIL;
+        }
+    }
+
+    return DCID_OK;
+}
+
+/*! wait for the internal write cycle to complete. the eeprom does not acknowledge its
+ *  address while busy, so address-only writes are retried until one is accepted. */
+static int i2c_wait_write(dcid_t *p_dcid, int page, int byte)
+{
+    const i2c_config_t *p_config = (const i2c_config_t*)p_dcid->backend->config;
+    unsigned char output = byte;
+    struct i2c_rdwr_ioctl_data packets;
+    struct i2c_msg messages[1];
+    struct timeval beg, now;
+    int poll;
+
+    messages[0].addr    = I2C_PAGE_ADDR(p_config, page);
+    messages[0].flags   = 0;
+    messages[0].len     = sizeof(output);
+    messages[0].buf     = &output;
+
+    packets.msgs    = messages;
+    packets.nmsgs   = 1;
+
+    gettimeofday(&beg, 0);
+
+    for(poll=0;poll<p_dcid->write_poll_limit;poll++)
+    {
+        uint64_t io_beg = DCID_IO_BEGIN(p_dcid);
+
+        int ret = (ioctl(p_dcid->device_file, I2C_RDWR, &packets) < 0) ? DCID_FAIL : DCID_OK;
+
+        dcid_util_io(p_dcid, DCID_IO_POLL, (page << 8) | byte, 0, "I2C_RDWR", io_beg, ret);
+
+        if(DCID_SUCCESS(ret)) { return DCID_OK; }
+
+        gettimeofday(&now, 0);
+
+        if((now.tv_sec - beg.tv_sec)*1000000 + (now.tv_usec - beg.tv_usec) >= p_dcid->write_timeout_us) { break; }
+
+        io_beg = DCID_IO_BEGIN(p_dcid);
+
+        usleep(DCID_EEPROM_POLL_DELAY_US);
+
+        dcid_util_io(p_dcid, DCID_IO_SLEEP, 0, DCID_EEPROM_POLL_DELAY_US, "usleep", io_beg, DCID_OK);
+    }
+
+    perror("Timed out waiting for write cycle");
+
+    return DCID_FAIL;
+}
+
+/*! write up to one eeprom write page with a single message, then wait for the write cycle */
+static int i2c_write_block(dcid_t *p_dcid, unsigned int addr, const uint8_t *data, int size)
+{
+    const i2c_config_t *p_config = (const i2c_config_t*)p_dcid->backend->config;
+    unsigned char output[1+DCID_EEPROM_WRITE_PAGE];
+    struct i2c_rdwr_ioctl_data packets;
+    struct i2c_msg messages[1];
+    int byte;
+    int page;
+    int v;
+
+    if(size <= 0 || size > DCID_EEPROM_WRITE_PAGE) { return DCID_INVALID_PARAM; }
+
+    // On this chip, the upper two bits of the memory address are
+    // represented in the i2c address, and the lower eight are clocked in
+    // as the memory address.  This gives a crude mechanism for 4 pages of
+    // 256 bytes each.
+    byte = (addr   ) & 0xff;
+    page = (addr>>8) & 0x03;
+
+    output[0] = byte;
+
+    for(v=0;v<size;v++) { output[1+v] = data[v]; }
+
+    messages[0].addr    = I2C_PAGE_ADDR(p_config, page);
+    messages[0].flags   = 0;
+    messages[0].len     = 1+size;
+    messages[0].buf     = output;
+
+    packets.msgs    = messages;
+    packets.nmsgs   = 1;
+
+    uint64_t beg = DCID_IO_BEGIN(p_dcid);
+
+    int ret = (ioctl(p_dcid->device_file, I2C_RDWR, &packets) < 0) ? DCID_FAIL : DCID_OK;
+
+    dcid_util_io(p_dcid, DCID_IO_WRITE, addr, size, "I2C_RDWR", beg, ret);
+
+    if(DCID_FAILED(ret)) {
+        char error[128];
+        snprintf(error, sizeof(error), "Unable to send v %d on page %d, byte %d\n", addr, page, byte);
+        perror(error);
+        return DCID_FAIL;
+    }
+
+    /*! wait until the page is committed before touching the bus again */
+    return i2c_wait_write(p_dcid, page, byte);
+}
+
+const dcid_backend_t dcid_backend_falconwing =
+{
+    "falconwing",
+    { DCID_EEPROM_PAGES*256, DCID_EEPROM_WRITE_PAGE, DCID_EEPROM_WRITE_CYCLE_US },
+    &falconwing_config,
+    dcid_backend_open_device,
+    i2c_read_block,
+    0,
+    i2c_write_block,
+    0,
+    dcid_backend_close_device,
+};
+
+const dcid_backend_t dcid_backend_silvermoon =
+{
+    "silvermoon",
+    { DCID_EEPROM_PAGES*256, DCID_EEPROM_WRITE_PAGE, DCID_EEPROM_WRITE_CYCLE_US },
+    &silvermoon_config,
+    dcid_backend_open_device,
+    i2c_read_block,
+    0,
+    i2c_write_block,
+    0,
+    dcid_backend_close_device,
+};
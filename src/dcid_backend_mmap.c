@@ -0,0 +1,198 @@
+/*
+ * dcid_backend_mmap.c
+ *
+ * dcid contributors
+ * (c) Copyright 2026
+ * All rights reserved
+ *
+ * This module implements the backend for a card image kept in a plain file, mapped into
+ * memory (avlite). Reads and writes are memory copies against the mapping, and a flush is
+ * one msync over the range written since the last one.
+ */
+
+#include "dcid_backend.h"
+#include "dcid_utility.h"
+
+#include <string.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*! smallest mapping, in bytes, which holds the image along with the card identity */
+#define DCID_MMAP_MIN_SIZE (DCID_MAX_RAW_SIZE + DCID_IDENT_SIZE)
+
+/*! settings for one flavour of the backend */
+typedef struct _mmap_config_t
+{
+    /*! non-zero to msync on flush, zero to leave write back to the kernel */
+    int sync;
+}
+mmap_config_t;
+
+static const mmap_config_t mmap_sync_config = { 1 };
+static const mmap_config_t mmap_nosync_config = { 0 };
+
+/*! per instance state, kept in dcid_t::backend_data */
+typedef struct _mmap_state_t
+{
+    /*! file mapping */
+    uint8_t *map;
+    /*! mapping size, in bytes */
+    size_t size;
+    /*! range written since the last flush, empty if dirty_end is 0 */
+    unsigned int dirty_beg, dirty_end;
+}
+mmap_state_t;
+
+/*! open image file as the file backend does, creating a blank one if needed, then map it */
+static int mmap_open(dcid_t *p_dcid, const char *path)
+{
+    mmap_state_t *p_state = 0;
+    struct stat st;
+
+    if(DCID_FAILED(dcid_backend_file.open(p_dcid, path))) { return DCID_FAIL; }
+
+    if(fstat(p_dcid->device_file, &st) != 0) { goto fail; }
+
+    /*! a short file would fault when touched past its end, so grow it (zero filled) first */
+    if(st.st_size < DCID_MMAP_MIN_SIZE)
+    {
+        if(ftruncate(p_dcid->device_file, DCID_MMAP_MIN_SIZE) != 0) { perror("Unable to extend"); goto fail; }
+
+        st.st_size = DCID_MMAP_MIN_SIZE;
+    }
+
+    p_state = (mmap_state_t*)malloc(sizeof(mmap_state_t));
+
+    if(p_state == 0) { goto fail; }
+
+    memset(p_state, 0, sizeof(mmap_state_t));
+
+    p_state->size = st.st_size;
+    p_state->map = (uint8_t*)mmap(0, p_state->size, PROT_READ | PROT_WRITE, MAP_SHARED, p_dcid->device_file, 0);
+
+    if(p_state->map == MAP_FAILED) { perror("Unable to map"); goto fail; }
+
+    p_dcid->backend_data = p_state;
+
+    return DCID_OK;
+
+fail:
+
+    if(p_state != 0) { free(p_state); }
+
+    dcid_backend_close_device(p_dcid);
+
+    return DCID_FAIL;
+}
+
+static int mmap_read_block(dcid_t *p_dcid, unsigned int addr, uint8_t *data, int size)
+{
+    mmap_state_t *p_state = (mmap_state_t*)p_dcid->backend_data;
+
+    uint64_t beg = DCID_IO_BEGIN(p_dcid);
+
+    if(addr + size > p_state->size) { return DCID_INVALID_PARAM; }
+
+    memcpy(data, &p_state->map[addr], size);
+
+    dcid_util_io(p_dcid, DCID_IO_READ, addr, size, "mmap", beg, DCID_OK);
+
+    return DCID_OK;
+}
+
+static int mmap_write_block(dcid_t *p_dcid, unsigned int addr, const uint8_t *data, int size)
+{
+    mmap_state_t *p_state = (mmap_state_t*)p_dcid->backend_data;
+
+    uint64_t beg = DCID_IO_BEGIN(p_dcid);
+
+    if(addr + size > p_state->size) { return DCID_INVALID_PARAM; }
+
+    memcpy(&p_state->map[addr], data, size);
+
+    /*! widen the range for the next msync */
+    if(p_state->dirty_end == 0 || addr < p_state->dirty_beg) { p_state->dirty_beg = addr; }
+    if(addr + size > p_state->dirty_end) { p_state->dirty_end = addr + size; }
+
+    dcid_util_io(p_dcid, DCID_IO_WRITE, addr, size, "mmap", beg, DCID_OK);
+
+    return DCID_OK;
+}
+
+/*! commit everything written since the last flush with a single msync */
+static int mmap_flush(dcid_t *p_dcid)
+{
+    const mmap_config_t *p_config = (const mmap_config_t*)p_dcid->backend->config;
+
+    mmap_state_t *p_state = (mmap_state_t*)p_dcid->backend_data;
+
+    int ret = DCID_OK;
+
+    if(p_state->dirty_end == 0) { return DCID_OK; }
+
+    if(p_config->sync)
+    {
+        /*! msync wants a page aligned start */
+        unsigned int page_mask = (unsigned int)sysconf(_SC_PAGESIZE) - 1;
+        unsigned int sync_beg = p_state->dirty_beg & ~page_mask;
+        unsigned int sync_len = p_state->dirty_end - sync_beg;
+
+        uint64_t beg = DCID_IO_BEGIN(p_dcid);
+
+        ret = (msync(p_state->map + sync_beg, sync_len, MS_SYNC) == 0) ? DCID_OK : DCID_FAIL;
+
+        dcid_util_io(p_dcid, DCID_IO_SYNC, sync_beg, sync_len, "msync", beg, ret);
+
+        if(DCID_FAILED(ret)) { perror("Unable to sync"); }
+    }
+
+    p_state->dirty_beg = p_state->dirty_end = 0;
+
+    return ret;
+}
+
+static int mmap_close(dcid_t *p_dcid)
+{
+    mmap_state_t *p_state = (mmap_state_t*)p_dcid->backend_data;
+
+    if(p_state != 0)
+    {
+        /*! anything not yet synced is still written back by the kernel */
+        munmap(p_state->map, p_state->size);
+
+        free(p_state);
+
+        p_dcid->backend_data = 0;
+    }
+
+    return dcid_backend_close_device(p_dcid);
+}
+
+const dcid_backend_t dcid_backend_mmap =
+{
+    "mmap",
+    { DCID_MMAP_MIN_SIZE, DCID_MAX_RAW_SIZE, 0 },
+    &mmap_sync_config,
+    mmap_open,
+    mmap_read_block,
+    0,
+    mmap_write_block,
+    mmap_flush,
+    mmap_close,
+};
+
+const dcid_backend_t dcid_backend_mmap_nosync =
+{
+    "mmap-nosync",
+    { DCID_MMAP_MIN_SIZE, DCID_MAX_RAW_SIZE, 0 },
+    &mmap_nosync_config,
+    mmap_open,
+    mmap_read_block,
+    0,
+    mmap_write_block,
+    mmap_flush,
+    mmap_close,
+};
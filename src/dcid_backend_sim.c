@@ -0,0 +1,204 @@
+/*
+ * dcid_backend_sim.c
+ *
+ * dcid contributors
+ * (c) Copyright 2026
+ * All rights reserved
+ *
+ * This module implements the simulated DCID backend. See dcid_sim.h.
+ */
+
+#define _GNU_SOURCE /* pread, pwrite */
+
+#include "dcid_sim.h"
+#include "dcid_utility.h"
+
+#include <string.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdio.h>
+
+/*! bus clocks per byte on the wire (8 data bits and an acknowledge) */
+#define SIM_CLOCKS_PER_BYTE 9
+
+/*! bus settings in effect */
+static dcid_sim_config_t sim_config =
+{
+    DCID_SIM_DEFAULT_BUS_HZ,
+    DCID_SIM_DEFAULT_TRANSACTION_US,
+    DCID_SIM_DEFAULT_MAX_READ,
+    DCID_SIM_DEFAULT_WRITE_PAGE,
+    DCID_SIM_DEFAULT_WRITE_CYCLE_US,
+    0
+};
+
+/*! counters since the last reset */
+static dcid_sim_stats_t sim_stats;
+
+/*! utility function for charging one transaction of wire_bytes bytes, plus any write cycle */
+static void sim_charge(int wire_bytes, int write_cycle)
+{
+    uint64_t time_us = sim_config.transaction_us + ((uint64_t)wire_bytes*SIM_CLOCKS_PER_BYTE*1000000)/sim_config.bus_hz;
+
+    if(write_cycle)
+    {
+        time_us += sim_config.write_cycle_us;
+        sim_stats.write_cycles++;
+    }
+
+    sim_stats.transactions++;
+    sim_stats.bus_time_us += time_us;
+
+    /*! the sleep stands in for bus time, so it is part of the transaction rather than a sleep of its own */
+    if(sim_config.realtime) { usleep(time_us); }
+}
+
+/*! open backing file, creating a blank one if it does not exist yet, and load its contents.
+ *  each instance simulates its own device, kept in dcid_t::backend_data */
+static int sim_open(dcid_t *p_dcid, const char *path)
+{
+    uint8_t *sim_image = (uint8_t*)malloc(DCID_SIM_DEVICE_SIZE);
+
+    if(sim_image == 0) { return DCID_OUT_OF_MEMORY; }
+
+    memset(sim_image, 0, DCID_SIM_DEVICE_SIZE);
+
+    p_dcid->device_file = open(path, O_RDWR | O_CREAT, 0644);
+
+    if(p_dcid->device_file == -1) { free(sim_image); return DCID_FAIL; }
+
+    /*! a short or new file reads as blank */
+    if(pread(p_dcid->device_file, sim_image, DCID_SIM_DEVICE_SIZE, 0) < 0) {
+        perror("Unable to read");
+        free(sim_image);
+        dcid_backend_close_device(p_dcid);
+        return DCID_FAIL;
+    }
+
+    p_dcid->backend_data = sim_image;
+
+    return DCID_OK;
+}
+
+static int sim_read_block(dcid_t *p_dcid, unsigned int addr, uint8_t *data, int size)
+{
+    uint8_t *sim_image = (uint8_t*)p_dcid->backend_data;
+
+    uint64_t beg = DCID_IO_BEGIN(p_dcid);
+
+    if(addr + size > DCID_SIM_DEVICE_SIZE || size > sim_config.max_read) { return DCID_INVALID_PARAM; }
+
+    memcpy(data, &sim_image[addr], size);
+
+    /*! each 256 byte page touched costs a device address, word address, and device address again */
+    {
+        int pages = ((addr + size - 1) >> 8) - (addr >> 8) + 1;
+
+        sim_charge(pages*3 + size, 0);
+    }
+
+    dcid_util_io(p_dcid, DCID_IO_READ, addr, size, "sim", beg, DCID_OK);
+
+    sim_stats.read_bytes += size;
+
+    return DCID_OK;
+}
+
+static int sim_write_block(dcid_t *p_dcid, unsigned int addr, const uint8_t *data, int size)
+{
+    uint8_t *sim_image = (uint8_t*)p_dcid->backend_data;
+
+    uint64_t beg = DCID_IO_BEGIN(p_dcid);
+
+    if(addr + size > DCID_SIM_DEVICE_SIZE || size <= 0) { return DCID_INVALID_PARAM; }
+
+    /*! a real eeprom would wrap around inside its write buffer, so treat this as a caller bug */
+    if((addr / sim_config.write_page) != ((addr + size - 1) / sim_config.write_page))
+    {
+        fprintf(stderr, "dcid sim: write of %d bytes at 0x%.03X crosses a %d byte write page\n", size, addr, sim_config.write_page);
+        return DCID_INVALID_PARAM;
+    }
+
+    memcpy(&sim_image[addr], data, size);
+
+    /*! device address and word address, then data */
+    sim_charge(2 + size, 1);
+
+    sim_stats.write_bytes += size;
+
+    /*! keep the backing file in step, so the card survives across processes */
+    int ret = (size == pwrite(p_dcid->device_file, data, size, addr)) ? DCID_OK : DCID_FAIL;
+
+    dcid_util_io(p_dcid, DCID_IO_WRITE, addr, size, "sim", beg, ret);
+
+    if(DCID_FAILED(ret)) {
+        perror("Unable to write");
+        return DCID_FAIL;
+    }
+
+    return DCID_OK;
+}
+
+static int sim_close(dcid_t *p_dcid)
+{
+    if(p_dcid->backend_data != 0)
+    {
+        free(p_dcid->backend_data);
+
+        p_dcid->backend_data = 0;
+    }
+
+    return dcid_backend_close_device(p_dcid);
+}
+
+dcid_backend_t dcid_backend_sim =
+{
+    "sim",
+    { DCID_SIM_DEFAULT_MAX_READ, DCID_SIM_DEFAULT_WRITE_PAGE, DCID_SIM_DEFAULT_WRITE_CYCLE_US },
+    0,
+    sim_open,
+    sim_read_block,
+    0,
+    sim_write_block,
+    0,
+    sim_close,
+};
+
+int dcid_sim_configure(const dcid_sim_config_t *p_config)
+{
+    dcid_sim_config_t config = { 0 };
+
+    if(p_config != 0) { config = *p_config; }
+
+    if(config.bus_hz <= 0)          { config.bus_hz = DCID_SIM_DEFAULT_BUS_HZ; }
+    if(config.transaction_us <= 0)  { config.transaction_us = DCID_SIM_DEFAULT_TRANSACTION_US; }
+    if(config.max_read <= 0)        { config.max_read = DCID_SIM_DEFAULT_MAX_READ; }
+    if(config.write_page <= 0)      { config.write_page = DCID_SIM_DEFAULT_WRITE_PAGE; }
+    if(config.write_cycle_us <= 0)  { config.write_cycle_us = DCID_SIM_DEFAULT_WRITE_CYCLE_US; }
+
+    sim_config = config;
+
+    /*! advertise the new granularity, so the core batches to it */
+    dcid_backend_sim.caps.max_read = config.max_read;
+    dcid_backend_sim.caps.write_page = config.write_page;
+    dcid_backend_sim.caps.write_cycle_us = config.write_cycle_us;
+
+    return DCID_OK;
+}
+
+int dcid_sim_get_stats(dcid_sim_stats_t *p_stats)
+{
+    if(p_stats == 0) { return DCID_INVALID_PARAM; }
+
+    *p_stats = sim_stats;
+
+    return DCID_OK;
+}
+
+int dcid_sim_reset_stats(void)
+{
+    memset(&sim_stats, 0, sizeof(sim_stats));
+
+    return DCID_OK;
+}
@@ -0,0 +1,254 @@
+/*
+ * dcid_cache.c
+ *
+ * dcid contributors
+ * (c) Copyright 2026
+ * All rights reserved
+ *
+ * This module implements the optional on-disk cache of decoded card data. Cache files
+ * are keyed by the card revision and serial number, which sit just past the DCID image
+ * and can be read cheaply. A cache file holds the card's record area, up to and including
+ * the trailer, along with the XML rendered from it. A hit costs reading the identity and
+ * that record area back from the card, which must match byte for byte, in place of the
+ * whole image plus decoding. Cards whose records fill most of the image are not cached,
+ * so a hit always reads less than a plain load would.
+ */
+
+#include "dcid_cache.h"
+#include "dcid_utility.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <malloc.h>
+#include <unistd.h>
+
+/*! cache file header */
+typedef struct _dcid_cache_hdr_t
+{
+    /*! file magic, "dcc2" */
+    char magic[4];
+    /*! card revision and serial number */
+    uint8_t ident[DCID_IDENT_SIZE];
+    /*! FNV-1a fingerprint of record area and rendered XML */
+    uint32_t fingerprint;
+    /*! record area size, in bytes (incl trailer) */
+    int32_t span;
+    /*! rendered XML size, in bytes (incl null terminator) */
+    int32_t xml_size;
+}
+dcid_cache_hdr_t;
+
+/*! utility function for computing an FNV-1a fingerprint */
+static uint32_t cache_fingerprint(uint32_t hash, const uint8_t *data, int size)
+{
+    int v;
+
+    for(v=0;v<size;v++)
+    {
+        hash ^= data[v];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+/*! utility function for measuring the record area of an image, up to and including the trailer */
+static int cache_span(const uint8_t *image)
+{
+    int pos = 4;
+
+    /*! validate header */
+    if(memcmp(image, "sexi", 4) != 0) { return 0; }
+
+    while(pos + 4 <= DCID_MAX_RAW_SIZE)
+    {
+        int size = image[pos+1] & 0x7F;
+
+        if(memcmp(&image[pos], "pus!", 4) == 0) { return pos + 4; }
+
+        if(size < DCID_RECORD_HDR_SIZE) { return 0; }
+
+        pos += size;
+    }
+
+    return 0;
+}
+
+/*! utility function for reading the card identity and building its cache file path */
+static int cache_path(dcid_t *p_dcid, uint8_t *ident, char *path, int path_size)
+{
+    int v, blank_00 = 1, blank_ff = 1;
+
+    if(p_dcid->cache_dir == 0) { return DCID_NOT_FOUND; }
+
+    int ret = dcid_util_read_ident(p_dcid, ident);
+
+    if(DCID_FAILED(ret)) { return ret; }
+
+    /*! unprogrammed cards cannot be told apart, so they are never cached */
+    for(v=0;v<DCID_IDENT_SIZE;v++)
+    {
+        if(ident[v] != 0x00) { blank_00 = 0; }
+        if(ident[v] != 0xFF) { blank_ff = 0; }
+    }
+
+    if(blank_00 || blank_ff) { return DCID_NOT_FOUND; }
+
+    int len = snprintf(path, path_size, "%s/dcid-", p_dcid->cache_dir);
+
+    for(v=0;v<DCID_IDENT_SIZE && len < path_size;v++)
+    {
+        len += snprintf(&path[len], path_size - len, "%.02X", ident[v]);
+    }
+
+    len += snprintf(&path[len], path_size - len, ".cache");
+
+    if(len >= path_size) { return DCID_BUFFER_TOO_SMALL; }
+
+    return DCID_OK;
+}
+
+int dcid_cache_load(dcid_t *p_dcid)
+{
+    uint8_t ident[DCID_IDENT_SIZE];
+    uint8_t span[DCID_CACHE_MAX_SPAN], card[DCID_CACHE_MAX_SPAN];
+    char path[1024];
+    dcid_cache_hdr_t hdr;
+    char *xml_data = 0;
+    FILE *cache_file = 0;
+
+    int ret = cache_path(p_dcid, ident, path, sizeof(path));
+
+    if(DCID_FAILED(ret)) { return ret; }
+
+    cache_file = fopen(path, "rb");
+
+    if(cache_file == 0) { return DCID_NOT_FOUND; }
+
+    ret = DCID_NOT_FOUND;
+
+    /*! validate header */
+    if(fread(&hdr, sizeof(hdr), 1, cache_file) != 1) { goto cleanup; }
+    if(memcmp(hdr.magic, "dcc2", 4) != 0) { goto cleanup; }
+    if(memcmp(hdr.ident, ident, DCID_IDENT_SIZE) != 0) { goto cleanup; }
+    if(hdr.span <= 4 || hdr.span > DCID_CACHE_MAX_SPAN) { goto cleanup; }
+    if(hdr.xml_size <= 0 || hdr.xml_size > DCID_CACHE_MAX_XML) { goto cleanup; }
+
+    xml_data = (char*)malloc(hdr.xml_size);
+
+    if(xml_data == 0) { ret = DCID_OUT_OF_MEMORY; goto cleanup; }
+
+    if(fread(span, hdr.span, 1, cache_file) != 1) { goto cleanup; }
+    if(fread(xml_data, hdr.xml_size, 1, cache_file) != 1) { goto cleanup; }
+
+    /*! validate contents */
+    {
+        uint32_t fingerprint = cache_fingerprint(2166136261u, span, hdr.span);
+
+        fingerprint = cache_fingerprint(fingerprint, (uint8_t*)xml_data, hdr.xml_size);
+
+        if(fingerprint != hdr.fingerprint || xml_data[hdr.xml_size-1] != '\0') { goto cleanup; }
+    }
+
+    /*! the card may have been reprogrammed elsewhere under the same serial number, so its
+     *  record area is read back and compared. this is all a hit reads of the image */
+    {
+        int size = hdr.span;
+
+        ret = dcid_util_read_raw(p_dcid, 0, card, &size);
+
+        if(DCID_FAILED(ret)) { goto cleanup; }
+
+        ret = DCID_NOT_FOUND;
+
+        if(memcmp(card, span, hdr.span) != 0) { goto cleanup; }
+    }
+
+    /*! hit - adopt rendered XML */
+    if(p_dcid->cache_xml != 0) { free(p_dcid->cache_xml); }
+
+    p_dcid->cache_xml = xml_data;
+    p_dcid->cache_xml_size = hdr.xml_size;
+
+    xml_data = 0;
+    ret = DCID_OK;
+
+cleanup:
+
+    if(xml_data != 0) { free(xml_data); }
+
+    fclose(cache_file);
+
+    return ret;
+}
+
+int dcid_cache_store(dcid_t *p_dcid, const char *xml_data, int size)
+{
+    uint8_t ident[DCID_IDENT_SIZE];
+    char path[1024], tmp_path[1100];
+    dcid_cache_hdr_t hdr;
+    FILE *cache_file = 0;
+
+    /*! only a complete image read from the device is worth keeping */
+    if(!p_dcid->image_valid || size <= 0 || size > DCID_CACHE_MAX_XML) { return DCID_INVALID_CALL; }
+
+    /*! a record area this large would cost nearly as much to check as the image does to read */
+    int span = cache_span(p_dcid->image);
+
+    if(span == 0 || span > DCID_CACHE_MAX_SPAN) { return DCID_NOT_FOUND; }
+
+    int ret = cache_path(p_dcid, ident, path, sizeof(path));
+
+    if(DCID_FAILED(ret)) { return ret; }
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, "dcc2", 4);
+    memcpy(hdr.ident, ident, DCID_IDENT_SIZE);
+    hdr.span = span;
+    hdr.xml_size = size;
+    hdr.fingerprint = cache_fingerprint(2166136261u, p_dcid->image, span);
+    hdr.fingerprint = cache_fingerprint(hdr.fingerprint, (const uint8_t*)xml_data, size);
+
+    /*! write to a temporary file, then move it into place, so readers never see a partial file */
+    snprintf(tmp_path, sizeof(tmp_path), "%s.%d", path, (int)getpid());
+
+    cache_file = fopen(tmp_path, "wb");
+
+    if(cache_file == 0) { return DCID_ACCESS_DENIED; }
+
+    ret = DCID_OK;
+
+    if(fwrite(&hdr, sizeof(hdr), 1, cache_file) != 1) { ret = DCID_FAIL; }
+    if(DCID_SUCCESS(ret) && fwrite(p_dcid->image, span, 1, cache_file) != 1) { ret = DCID_FAIL; }
+    if(DCID_SUCCESS(ret) && fwrite(xml_data, size, 1, cache_file) != 1) { ret = DCID_FAIL; }
+
+    if(fclose(cache_file) != 0) { ret = DCID_FAIL; }
+
+    if(DCID_SUCCESS(ret) && rename(tmp_path, path) != 0) { ret = DCID_FAIL; }
+
+    if(DCID_FAILED(ret)) { unlink(tmp_path); }
+
+    return ret;
+}
+
+int dcid_cache_invalidate(dcid_t *p_dcid)
+{
+    uint8_t ident[DCID_IDENT_SIZE];
+    char path[1024];
+
+    /*! drop rendered XML held in memory */
+    if(p_dcid->cache_xml != 0)
+    {
+        free(p_dcid->cache_xml);
+        p_dcid->cache_xml = 0;
+        p_dcid->cache_xml_size = 0;
+    }
+
+    int ret = cache_path(p_dcid, ident, path, sizeof(path));
+
+    if(DCID_FAILED(ret)) { return ret; }
+
+    unlink(path);
+
+    return DCID_OK;
+}
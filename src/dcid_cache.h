@@ -0,0 +1,40 @@
+/*
+ * dcid_cache.h
+ *
+ * dcid contributors
+ * (c) Copyright 2026
+ * All rights reserved
+ *
+ * This API defines the optional on-disk cache of decoded card data.
+ */
+
+#ifndef DCID_CACHE_H
+#define DCID_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "dcid_interface.h"
+
+/*! largest rendered XML kept in a cache file, in bytes */
+#define DCID_CACHE_MAX_XML (DCID_MAX_XML_SIZE*16)
+
+/*! largest record area kept in a cache file, in bytes. a hit reads this much of the card */
+#define DCID_CACHE_MAX_SPAN (DCID_MAX_RAW_SIZE/2)
+
+/*! take rendered XML from the cache file for this card, if its record area matches the card.
+ *  reads only the card identity and record area, so the shadow image is left unloaded */
+int dcid_cache_load(dcid_t *p_dcid);
+
+/*! write the record area of the shadow image and rendered XML to the cache file for this card */
+int dcid_cache_store(dcid_t *p_dcid, const char *xml_data, int size);
+
+/*! forget cached data for this card, after its contents have changed */
+int dcid_cache_invalidate(dcid_t *p_dcid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,485 @@
+/*
+ * dcid_daemon.c
+ *
+ * dcid contributors
+ * (c) Copyright 2026
+ * All rights reserved
+ *
+ * This module implements the resident DCID server and its client calls.
+ */
+
+#define _GNU_SOURCE /* struct ucred */
+
+#include "dcid_daemon.h"
+#include "dcid_utility.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <malloc.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <libgen.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/*! largest request or reply payload, in bytes */
+#define DCID_DAEMON_MAX_PAYLOAD DCID_MAX_XML_SIZE
+
+/*! time a connected client may stall a request before it is dropped, in seconds */
+#define DCID_DAEMON_CLIENT_TIMEOUT 2
+
+/*! most clients connected at once. further connections wait in the listen backlog */
+#define DCID_DAEMON_MAX_CLIENTS 16
+
+/*! utility function for sending an entire buffer */
+static int send_all(int fd, const void *data, int size)
+{
+    const uint8_t *cur = (const uint8_t*)data;
+
+    while(size > 0)
+    {
+        ssize_t ret = send(fd, cur, size, MSG_NOSIGNAL);
+
+        if(ret < 0 && errno == EINTR) { continue; }
+
+        if(ret <= 0) { return DCID_FAIL; }
+
+        cur += ret;
+        size -= ret;
+    }
+
+    return DCID_OK;
+}
+
+/*! utility function for receiving an entire buffer */
+static int recv_all(int fd, void *data, int size)
+{
+    uint8_t *cur = (uint8_t*)data;
+
+    while(size > 0)
+    {
+        ssize_t ret = recv(fd, cur, size, 0);
+
+        if(ret < 0 && errno == EINTR) { continue; }
+
+        if(ret <= 0) { return DCID_FAIL; }
+
+        cur += ret;
+        size -= ret;
+    }
+
+    return DCID_OK;
+}
+
+/*! utility function for filling in a socket address */
+static int socket_addr(const char *socket_path, struct sockaddr_un *p_addr)
+{
+    if(socket_path == 0) { socket_path = DCID_DAEMON_SOCKET_PATH; }
+
+    if(strlen(socket_path) >= sizeof(p_addr->sun_path)) { return DCID_INVALID_PARAM; }
+
+    memset(p_addr, 0, sizeof(*p_addr));
+    p_addr->sun_family = AF_UNIX;
+    strcpy(p_addr->sun_path, socket_path);
+
+    return DCID_OK;
+}
+
+/*! utility function for checking that a user may be trusted with the card. that is root,
+ *  or the user this process runs as, who can reach the device just as well */
+static int trusted_uid(uid_t uid)
+{
+    return uid == 0 || uid == geteuid();
+}
+
+/*! utility function for fetching the user at the other end of a connection */
+static int peer_uid(int fd, uid_t *p_uid)
+{
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+
+    if(getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0) { return DCID_FAIL; }
+
+    *p_uid = cred.uid;
+
+    return DCID_OK;
+}
+
+/*! utility function for making sure nobody else can create or replace the socket. its
+ *  directory is created if missing, and must belong to a trusted user and be writable
+ *  by nobody else */
+static int socket_dir(const struct sockaddr_un *p_addr)
+{
+    char path[sizeof(p_addr->sun_path)];
+    struct stat st;
+
+    strcpy(path, p_addr->sun_path);
+
+    char *dir = dirname(path);
+
+    if(mkdir(dir, 0755) != 0 && errno != EEXIST)
+    {
+        perror("Unable to create socket directory");
+        return DCID_FAIL;
+    }
+
+    if(lstat(dir, &st) != 0) { return DCID_FAIL; }
+
+    if(!S_ISDIR(st.st_mode) || !trusted_uid(st.st_uid) || (st.st_mode & (S_IWGRP | S_IWOTH)) != 0)
+    {
+        fprintf(stderr, "Error: socket directory %s must belong to root, and be writable by nobody else\n", dir);
+        return DCID_ACCESS_DENIED;
+    }
+
+    return DCID_OK;
+}
+
+/*! utility function for carrying out a single request */
+static void serve_request(dcid_t *p_dcid, int fd, dcid_daemon_msg_t *p_req, char *payload, char *reply_data, dcid_daemon_msg_t *p_reply)
+{
+    int size = p_req->size;
+
+    /*! never hand out more than the reply buffer holds */
+    if(size > DCID_DAEMON_MAX_PAYLOAD) { size = DCID_DAEMON_MAX_PAYLOAD; }
+    if(size < 0) { size = 0; }
+
+    p_reply->len = 0;
+
+    switch(p_req->op)
+    {
+        case DCID_DAEMON_READ_XML:
+        {
+            p_reply->op = dcid_read_xml(p_dcid, reply_data, &size);
+
+            if(DCID_SUCCESS(p_reply->op)) { p_reply->len = size; }
+        }
+        break;
+
+        case DCID_DAEMON_READ_IMAGE:
+        {
+            p_reply->op = dcid_read_image(p_dcid, (uint8_t*)reply_data, &size);
+
+            if(DCID_SUCCESS(p_reply->op)) { p_reply->len = size; }
+        }
+        break;
+
+        case DCID_DAEMON_GET:
+        {
+            /*! path must be null terminated */
+            if(p_req->len <= 0 || payload[p_req->len-1] != '\0') { p_reply->op = DCID_INVALID_PARAM; break; }
+
+            p_reply->op = dcid_get(p_dcid, payload, (uint8_t*)reply_data, &size);
+
+            if(DCID_SUCCESS(p_reply->op)) { p_reply->len = size; }
+        }
+        break;
+
+        case DCID_DAEMON_WRITE_XML:
+        {
+#ifdef DCID_ALLOW_WRITE
+            uint8_t blank[DCID_MAX_RAW_SIZE];
+            int blank_size = sizeof(blank);
+            uid_t uid;
+
+            /*! anyone may read the card, but only root may rewrite it */
+            if(DCID_FAILED(peer_uid(fd, &uid)) || !trusted_uid(uid)) { p_reply->op = DCID_ACCESS_DENIED; break; }
+
+            /*! stage a blank card first, so each request writes the same image a fresh instance would */
+
+            memset(blank, 0, sizeof(blank));
+
+            /*! the reply reports how many XML bytes were consumed, and 0 until they are */
+            size = 0;
+
+            p_reply->op = dcid_util_write_raw(p_dcid, 0, blank, &blank_size);
+
+            if(DCID_FAILED(p_reply->op)) { break; }
+
+            /*! encode it as a stream, so a document cut short in transit is refused rather than committed */
+            p_reply->op = dcid_write_begin(p_dcid);
+
+            if(DCID_SUCCESS(p_reply->op)) { p_reply->op = dcid_write_feed(p_dcid, payload, p_req->len); }
+
+            if(DCID_SUCCESS(p_reply->op)) { p_reply->op = dcid_write_end(p_dcid, 1); } else { dcid_write_end(p_dcid, 0); }
+
+            if(DCID_SUCCESS(p_reply->op)) { size = p_req->len; }
+#else
+            p_reply->op = DCID_ACCESS_DENIED;
+#endif
+        }
+        break;
+
+        default:
+            p_reply->op = DCID_NOTIMPL;
+            break;
+    }
+
+    p_reply->size = size;
+}
+
+/*! utility function for serving the next request from a client. fails once the client
+ *  has gone, or has sent something which cannot be answered */
+static int serve_client(dcid_t *p_dcid, int fd, char *payload, char *reply_data)
+{
+    dcid_daemon_msg_t req, reply;
+
+    if(DCID_FAILED(recv_all(fd, &req, sizeof(req)))) { return DCID_FAIL; }
+
+    /*! malformed request - there is no way to resynchronize, so drop the client */
+    if(req.len < 0 || req.len > DCID_DAEMON_MAX_PAYLOAD) { return DCID_FAIL; }
+
+    if(DCID_FAILED(recv_all(fd, payload, req.len))) { return DCID_FAIL; }
+
+    serve_request(p_dcid, fd, &req, payload, reply_data, &reply);
+
+    if(DCID_FAILED(send_all(fd, &reply, sizeof(reply)))) { return DCID_FAIL; }
+
+    return send_all(fd, reply_data, reply.len);
+}
+
+int dcid_daemon_run(struct _dcid_t *p_dcid, const char *socket_path)
+{
+    struct sockaddr_un addr;
+    int listen_fd = -1;
+
+    /*! sanity check - null ptr */
+    if(p_dcid == 0) { return DCID_INVALID_PARAM; }
+
+    int ret = socket_addr(socket_path, &addr);
+
+    if(DCID_FAILED(ret)) { return ret; }
+
+    ret = socket_dir(&addr);
+
+    if(DCID_FAILED(ret)) { return ret; }
+
+    /*! load the image up front, so no client waits on the device for reads */
+    ret = dcid_util_load_image(p_dcid);
+
+    if(DCID_FAILED(ret)) { return ret; }
+
+    /*! refuse to take over from a live server, but clear out a stale socket */
+    {
+        int fd = -1;
+
+        if(DCID_SUCCESS(dcid_client_open(socket_path, &fd)))
+        {
+            dcid_client_close(fd);
+            return DCID_ACCESS_DENIED;
+        }
+
+        unlink(addr.sun_path);
+    }
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if(listen_fd == -1) { return DCID_FAIL; }
+
+    /*! anyone may connect to read. writes are checked per request */
+    if(bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || chmod(addr.sun_path, 0666) != 0 || listen(listen_fd, 16) != 0)
+    {
+        perror("Unable to create socket");
+        close(listen_fd);
+        return DCID_FAIL;
+    }
+
+    /*! one request buffer and one reply buffer, shared by all clients */
+    char *payload = (char*)malloc(DCID_DAEMON_MAX_PAYLOAD+1);
+    char *reply_data = (char*)malloc(DCID_DAEMON_MAX_PAYLOAD);
+
+    if(payload == 0 || reply_data == 0) { ret = DCID_OUT_OF_MEMORY; goto cleanup; }
+
+    /*! clients take turns, one request each, so no client can hold the others off. requests
+     *  are still carried out one at a time, which also serializes writes */
+    {
+        struct pollfd fds[1 + DCID_DAEMON_MAX_CLIENTS];
+        int count = 1, v;
+
+        fds[0].fd = listen_fd;
+        fds[0].events = POLLIN;
+
+        for(;;)
+        {
+            /*! once full, new connections wait until a client leaves */
+            fds[0].events = (count < 1 + DCID_DAEMON_MAX_CLIENTS) ? POLLIN : 0;
+
+            if(poll(fds, count, -1) < 0)
+            {
+                if(errno == EINTR) { continue; }
+
+                perror("Unable to poll");
+                ret = DCID_FAIL;
+                break;
+            }
+
+            for(v=count-1;v>=1;v--)
+            {
+                if(fds[v].revents == 0) { continue; }
+
+                if((fds[v].revents & POLLIN) && DCID_SUCCESS(serve_client(p_dcid, fds[v].fd, payload, reply_data))) { continue; }
+
+                /*! gone, or misbehaving */
+                close(fds[v].fd);
+
+                fds[v] = fds[--count];
+            }
+
+            if(fds[0].revents & POLLIN)
+            {
+                int fd = accept(listen_fd, 0, 0);
+
+                if(fd == -1)
+                {
+                    if(errno == EINTR || errno == ECONNABORTED) { continue; }
+
+                    perror("Unable to accept");
+                    ret = DCID_FAIL;
+                    break;
+                }
+
+                /*! a stalled client must not hold up everybody else */
+                {
+                    struct timeval tv = { DCID_DAEMON_CLIENT_TIMEOUT, 0 };
+
+                    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+                    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+                }
+
+                fds[count].fd = fd;
+                fds[count].events = POLLIN;
+                fds[count].revents = 0;
+                count++;
+            }
+        }
+
+        for(v=1;v<count;v++) { close(fds[v].fd); }
+    }
+
+cleanup:
+
+    if(payload != 0) { free(payload); }
+    if(reply_data != 0) { free(reply_data); }
+
+    close(listen_fd);
+    unlink(addr.sun_path);
+
+    return ret;
+}
+
+int dcid_client_open(const char *socket_path, int *p_fd)
+{
+    struct sockaddr_un addr;
+
+    /*! sanity check - null ptr */
+    if(p_fd == 0) { return DCID_INVALID_PARAM; }
+
+    int ret = socket_addr(socket_path, &addr);
+
+    if(DCID_FAILED(ret)) { return ret; }
+
+    struct stat st;
+
+    if(lstat(addr.sun_path, &st) != 0) { return DCID_NOT_FOUND; }
+
+    /*! card data is only taken from a server run by root (or by this user) */
+    if(!S_ISSOCK(st.st_mode) || !trusted_uid(st.st_uid)) { return DCID_ACCESS_DENIED; }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if(fd == -1) { return DCID_FAIL; }
+
+    if(connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+    {
+        close(fd);
+        return DCID_NOT_FOUND;
+    }
+
+    /*! the socket may have been replaced since it was checked, so check the server itself */
+    {
+        uid_t uid;
+
+        if(DCID_FAILED(peer_uid(fd, &uid)) || !trusted_uid(uid))
+        {
+            close(fd);
+            return DCID_ACCESS_DENIED;
+        }
+    }
+
+    *p_fd = fd;
+
+    return DCID_OK;
+}
+
+int dcid_client_close(int fd)
+{
+    if(fd == -1) { return DCID_INVALID_PARAM; }
+
+    close(fd);
+
+    return DCID_OK;
+}
+
+/*! utility function for a single request/reply exchange with the server */
+static int client_call(int fd, int op, const void *payload, int len, void *reply_data, int *p_size)
+{
+    dcid_daemon_msg_t req, reply;
+
+    /*! sanity check - null ptr */
+    if(p_size == 0) { return DCID_INVALID_PARAM; }
+
+    /*! sanity check - request must fit the server's buffer */
+    if(len < 0 || len > DCID_DAEMON_MAX_PAYLOAD) { return DCID_INVALID_PARAM; }
+
+    req.op = op;
+    req.size = *p_size;
+    req.len = len;
+
+    if(DCID_FAILED(send_all(fd, &req, sizeof(req)))) { return DCID_FAIL; }
+    if(DCID_FAILED(send_all(fd, payload, len))) { return DCID_FAIL; }
+
+    if(DCID_FAILED(recv_all(fd, &reply, sizeof(reply)))) { return DCID_FAIL; }
+
+    /*! server never sends more than was asked for */
+    if(reply.len < 0 || reply.len > *p_size) { return DCID_FAIL; }
+
+    if(DCID_FAILED(recv_all(fd, reply_data, reply.len))) { return DCID_FAIL; }
+
+    *p_size = reply.size;
+
+    return reply.op;
+}
+
+int dcid_client_read_xml(int fd, char *xml_data, int *p_size)
+{
+    return client_call(fd, DCID_DAEMON_READ_XML, 0, 0, xml_data, p_size);
+}
+
+int dcid_client_read_image(int fd, uint8_t *raw_data, int *p_size)
+{
+    return client_call(fd, DCID_DAEMON_READ_IMAGE, 0, 0, raw_data, p_size);
+}
+
+int dcid_client_get(int fd, const char *path, uint8_t *data, int *p_size)
+{
+    /*! sanity check - null ptr */
+    if(path == 0) { return DCID_INVALID_PARAM; }
+
+    return client_call(fd, DCID_DAEMON_GET, path, strlen(path)+1, data, p_size);
+}
+
+int dcid_client_write_xml(int fd, char *xml_data, int *p_size)
+{
+    int size = 0;
+
+    /*! sanity check - null ptr */
+    if(p_size == 0 || xml_data == 0) { return DCID_INVALID_PARAM; }
+
+    int ret = client_call(fd, DCID_DAEMON_WRITE_XML, xml_data, *p_size, 0, &size);
+
+    if(DCID_SUCCESS(ret)) { *p_size = size; }
+
+    return ret;
+}
@@ -0,0 +1,258 @@
+/*
+ * dcid_flush.c
+ *
+ * dcid contributors
+ * (c) Copyright 2026
+ * All rights reserved
+ *
+ * This module implements the background flush of the write cache, on a worker thread
+ * (see dcid_write_flush_async in dcid_interface.h).
+ */
+
+#include "dcid_interface.h"
+#include "dcid_utility.h"
+
+#include <string.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+
+/*!
+
+  @brief DCID background flush state
+
+*/
+
+typedef struct _dcid_flush_t
+{
+    /*! worker thread */
+    pthread_t thread;
+    /*! set while the worker thread exists, and has not been joined */
+    int started;
+    /*! guards everything below, which the worker updates */
+    pthread_mutex_t lock;
+    /*! set from start until the worker has finished flushing */
+    int active;
+    /*! set to ask the worker to stop */
+    int cancel;
+    /*! progress, in bytes */
+    int done, total;
+    /*! result of the last flush */
+    int result;
+    /*! completion pipe. one byte is written to fds[1] when the worker finishes */
+    int fds[2];
+    /*! completion callback, 0 for none */
+    dcid_flush_callback_t callback;
+    /*! passed to callback */
+    void *p_context;
+}
+dcid_flush_t;
+
+/*! utility function for fetching flush state, creating it on first use */
+static dcid_flush_t *flush_state(dcid_t *p_dcid)
+{
+    dcid_flush_t *p_flush = p_dcid->flush;
+
+    if(p_flush != 0) { return p_flush; }
+
+    p_flush = (dcid_flush_t*)malloc(sizeof(dcid_flush_t));
+
+    if(p_flush == 0) { return 0; }
+
+    memset(p_flush, 0, sizeof(dcid_flush_t));
+
+    if(pipe(p_flush->fds) != 0)
+    {
+        free(p_flush);
+        return 0;
+    }
+
+    /*! draining must never block */
+    fcntl(p_flush->fds[0], F_SETFL, fcntl(p_flush->fds[0], F_GETFL) | O_NONBLOCK);
+
+    pthread_mutex_init(&p_flush->lock, 0);
+
+    p_flush->result = DCID_OK;
+
+    p_dcid->flush = p_flush;
+
+    return p_flush;
+}
+
+/*! worker thread entry point */
+static void *flush_worker(void *arg)
+{
+    dcid_t *p_dcid = (dcid_t*)arg;
+    dcid_flush_t *p_flush = p_dcid->flush;
+
+    int ret = dcid_util_write_flush(p_dcid);
+
+    pthread_mutex_lock(&p_flush->lock);
+
+    p_flush->result = ret;
+    p_flush->active = 0;
+
+    pthread_mutex_unlock(&p_flush->lock);
+
+    /*! wake anyone polling the descriptor */
+    {
+        char byte = 0;
+
+        while(write(p_flush->fds[1], &byte, 1) == -1 && errno == EINTR) { }
+    }
+
+    if(p_flush->callback != 0) { p_flush->callback(p_dcid, ret, p_flush->p_context); }
+
+    return 0;
+}
+
+int dcid_write_flush_async(struct _dcid_t *p_dcid, dcid_flush_callback_t callback, void *p_context)
+{
+    /*! sanity check - null ptr */
+    if(p_dcid == 0) { return DCID_INVALID_PARAM; }
+
+    /*! one flush at a time */
+    dcid_flush_wait(p_dcid);
+
+    dcid_flush_t *p_flush = flush_state(p_dcid);
+
+    if(p_flush == 0) { return DCID_OUT_OF_MEMORY; }
+
+    p_flush->active = 1;
+    p_flush->cancel = 0;
+    p_flush->done = p_flush->total = 0;
+    p_flush->result = DCID_OK;
+    p_flush->callback = callback;
+    p_flush->p_context = p_context;
+
+    if(pthread_create(&p_flush->thread, 0, flush_worker, p_dcid) != 0)
+    {
+        p_flush->active = 0;
+        return DCID_FAIL;
+    }
+
+    p_flush->started = 1;
+
+    return DCID_OK;
+}
+
+int dcid_flush_progress(struct _dcid_t *p_dcid, int *p_done, int *p_total)
+{
+    /*! sanity check - null ptr */
+    if(p_dcid == 0 || p_done == 0 || p_total == 0) { return DCID_INVALID_PARAM; }
+
+    dcid_flush_t *p_flush = p_dcid->flush;
+
+    *p_done = *p_total = 0;
+
+    if(p_flush == 0) { return DCID_OK; }
+
+    pthread_mutex_lock(&p_flush->lock);
+
+    *p_done = p_flush->done;
+    *p_total = p_flush->total;
+
+    pthread_mutex_unlock(&p_flush->lock);
+
+    return DCID_OK;
+}
+
+int dcid_flush_fd(struct _dcid_t *p_dcid, int *p_fd)
+{
+    /*! sanity check - null ptr */
+    if(p_dcid == 0 || p_fd == 0) { return DCID_INVALID_PARAM; }
+
+    dcid_flush_t *p_flush = flush_state(p_dcid);
+
+    if(p_flush == 0) { return DCID_OUT_OF_MEMORY; }
+
+    *p_fd = p_flush->fds[0];
+
+    return DCID_OK;
+}
+
+int dcid_flush_wait(struct _dcid_t *p_dcid)
+{
+    /*! sanity check - null ptr */
+    if(p_dcid == 0) { return DCID_INVALID_PARAM; }
+
+    dcid_flush_t *p_flush = p_dcid->flush;
+
+    if(p_flush == 0) { return DCID_OK; }
+
+    if(p_flush->started)
+    {
+        char byte;
+
+        pthread_join(p_flush->thread, 0);
+
+        p_flush->started = 0;
+
+        /*! the descriptor is readable until now */
+        while(read(p_flush->fds[0], &byte, 1) == 1) { }
+    }
+
+    return p_flush->result;
+}
+
+int dcid_flush_cancel(struct _dcid_t *p_dcid)
+{
+    /*! sanity check - null ptr */
+    if(p_dcid == 0) { return DCID_INVALID_PARAM; }
+
+    dcid_flush_t *p_flush = p_dcid->flush;
+
+    if(p_flush == 0) { return DCID_OK; }
+
+    pthread_mutex_lock(&p_flush->lock);
+
+    p_flush->cancel = 1;
+
+    pthread_mutex_unlock(&p_flush->lock);
+
+    return DCID_OK;
+}
+
+int dcid_flush_report(dcid_t *p_dcid, int done, int total)
+{
+    dcid_flush_t *p_flush = p_dcid->flush;
+
+    int cancel = 0;
+
+    /*! only a background flush has anyone to report to */
+    if(p_flush == 0) { return 0; }
+
+    pthread_mutex_lock(&p_flush->lock);
+
+    if(p_flush->active)
+    {
+        p_flush->done = done;
+        p_flush->total = total;
+
+        cancel = p_flush->cancel;
+    }
+
+    pthread_mutex_unlock(&p_flush->lock);
+
+    return cancel;
+}
+
+void dcid_flush_destroy(dcid_t *p_dcid)
+{
+    dcid_flush_t *p_flush = p_dcid->flush;
+
+    if(p_flush == 0) { return; }
+
+    dcid_flush_wait(p_dcid);
+
+    close(p_flush->fds[0]);
+    close(p_flush->fds[1]);
+
+    pthread_mutex_destroy(&p_flush->lock);
+
+    free(p_flush);
+
+    p_dcid->flush = 0;
+}
@@ -0,0 +1,152 @@
+/*
+ * dcid_index.c
+ *
+ * dcid contributors
+ * (c) Copyright 2026
+ * All rights reserved
+ *
+ * This module implements the in-memory tag index, which maps tag paths to records
+ * once per image load so that repeated lookups do not re-walk the image.
+ */
+
+#include "dcid_index.h"
+
+#include <string.h>
+
+/*! hash bucket for a (parent, tag id) key */
+static unsigned int index_hash(uint16_t parent, uint32_t tag)
+{
+    return ((tag ^ ((uint32_t)parent << 16)) * 2654435761u >> 24) & (DCID_INDEX_BUCKETS-1);
+}
+
+/*! utility function for finding a child entry by tag id */
+static const dcid_index_entry_t *index_lookup(const dcid_index_t *p_index, uint16_t parent, uint32_t tag)
+{
+    uint16_t cur = p_index->bucket[index_hash(parent, tag)];
+
+    while(cur != DCID_INDEX_NONE)
+    {
+        const dcid_index_entry_t *p_entry = &p_index->entry[cur];
+
+        if(p_entry->tag == tag && p_entry->parent == parent) { return p_entry; }
+
+        cur = p_entry->next;
+    }
+
+    return 0;
+}
+
+/*! utility function for recursively indexing records between pos and end */
+static int index_records(dcid_index_t *p_index, const uint8_t *image, int pos, int end, uint16_t parent)
+{
+    while(pos < end)
+    {
+        const uint8_t *rec = &image[pos];
+
+        /*! top level records run up to the trailer */
+        if(parent == DCID_INDEX_NONE)
+        {
+            if(pos + 4 > end) { return DCID_FAIL; }
+
+            if(memcmp(rec, "pus!", 4) == 0) { return DCID_OK; }
+        }
+
+        int size = rec[1] & 0x7F;
+
+        /*! record must fit inside its parent */
+        if(pos + DCID_RECORD_HDR_SIZE > end || size < DCID_RECORD_HDR_SIZE || pos + size > end) { return DCID_FAIL; }
+
+        if(p_index->count >= DCID_INDEX_MAX_ENTRIES) { return DCID_FAIL; }
+
+        uint16_t cur = p_index->count++;
+
+        dcid_index_entry_t *p_entry = &p_index->entry[cur];
+
+        p_entry->tag = DCID_TAG_ID(&rec[2]);
+        p_entry->parent = parent;
+        p_entry->next = DCID_INDEX_NONE;
+        p_entry->offset = pos;
+        p_entry->size = size - DCID_RECORD_HDR_SIZE;
+        p_entry->is_container = (rec[1] & 0x80) ? 1 : 0;
+
+        /*! first record wins among siblings sharing a tag, as in a sequential walk */
+        if(index_lookup(p_index, parent, p_entry->tag) == 0)
+        {
+            unsigned int hash = index_hash(parent, p_entry->tag);
+
+            p_entry->next = p_index->bucket[hash];
+            p_index->bucket[hash] = cur;
+        }
+
+        if(p_entry->is_container)
+        {
+            int ret = index_records(p_index, image, pos + DCID_RECORD_HDR_SIZE, pos + size, cur);
+
+            if(DCID_FAILED(ret)) { return ret; }
+        }
+
+        pos += size;
+    }
+
+    /*! top level must end with the trailer */
+    if(parent == DCID_INDEX_NONE) { return DCID_FAIL; }
+
+    return DCID_OK;
+}
+
+int dcid_index_update(dcid_t *p_dcid)
+{
+    dcid_index_t *p_index = p_dcid->index;
+
+    /*! index is only meaningful for a loaded image */
+    if(!p_dcid->image_valid) { return DCID_INVALID_CALL; }
+
+    /*! already current */
+    if(p_dcid->index_valid) { return DCID_OK; }
+
+    /*! validate header */
+    if(memcmp(p_dcid->image, "sexi", 4) != 0) { return DCID_FAIL; }
+
+    p_index->count = 0;
+    memset(p_index->bucket, 0xFF, sizeof(p_index->bucket));
+
+    int ret = index_records(p_index, p_dcid->image, 4, DCID_MAX_RAW_SIZE, DCID_INDEX_NONE);
+
+    if(DCID_FAILED(ret)) { return ret; }
+
+    p_dcid->index_valid = 1;
+
+    return DCID_OK;
+}
+
+int dcid_index_find(const dcid_index_t *p_index, const char *path, const dcid_index_entry_t **pp_entry)
+{
+    const dcid_index_entry_t *p_entry = 0;
+
+    uint16_t parent = DCID_INDEX_NONE;
+
+    /*! leading separator is optional */
+    if(*path == '/') { path++; }
+
+    while(1)
+    {
+        /*! each path element is exactly one tag */
+        if(strlen(path) < 4 || (path[4] != '/' && path[4] != '\0')) { return DCID_INVALID_PARAM; }
+
+        p_entry = index_lookup(p_index, parent, DCID_TAG_ID(path));
+
+        if(p_entry == 0) { return DCID_NOT_FOUND; }
+
+        if(path[4] == '\0') { break; }
+
+        /*! descend into matching container */
+        if(!p_entry->is_container) { return DCID_NOT_FOUND; }
+
+        parent = p_entry - p_index->entry;
+        path += 5;
+    }
+
+    *pp_entry = p_entry;
+
+    return DCID_OK;
+}
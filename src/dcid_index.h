@@ -0,0 +1,86 @@
+/*
+ * dcid_index.h
+ *
+ * dcid contributors
+ * (c) Copyright 2026
+ * All rights reserved
+ *
+ * This API defines the in-memory tag index used by dcid_interface.
+ */
+
+#ifndef DCID_INDEX_H
+#define DCID_INDEX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "dcid_interface.h"
+
+/*! pack a 4 character tag into its uint32 tag id */
+#define DCID_TAG_ID(p) (((uint32_t)(uint8_t)(p)[0] << 24) | ((uint32_t)(uint8_t)(p)[1] << 16) | \
+                        ((uint32_t)(uint8_t)(p)[2] <<  8) | ((uint32_t)(uint8_t)(p)[3]))
+
+/*! parent of top level entries, and end of hash chain */
+#define DCID_INDEX_NONE     0xFFFF
+/*! number of hash buckets, must be a power of two */
+#define DCID_INDEX_BUCKETS  0x100
+/*! maximum number of entries, given that every record carries a header */
+#define DCID_INDEX_MAX_ENTRIES (DCID_MAX_RAW_SIZE/DCID_RECORD_HDR_SIZE)
+
+/*! 
+
+  @brief DCID index entry
+
+  One entry per record in the image. Entries refer to each other by position, so the
+  index can be copied as is (see dcid_shm).
+
+*/
+
+typedef struct _dcid_index_entry_t
+{
+    /*! packed tag id */
+    uint32_t tag;
+    /*! entry position of enclosing container, DCID_INDEX_NONE at top level */
+    uint16_t parent;
+    /*! next entry in the same hash bucket, DCID_INDEX_NONE at end of chain */
+    uint16_t next;
+    /*! image offset of the record header */
+    uint16_t offset;
+    /*! payload size, in bytes */
+    uint8_t size;
+    /*! non-zero if the record holds child records */
+    uint8_t is_container;
+}
+dcid_index_entry_t;
+
+/*! 
+
+  @brief DCID index
+
+  Hash table mapping (parent entry, tag id) to record entries.
+
+*/
+
+typedef struct _dcid_index_t
+{
+    /*! number of entries in use */
+    uint16_t count;
+    /*! first entry of each hash bucket, DCID_INDEX_NONE if empty */
+    uint16_t bucket[DCID_INDEX_BUCKETS];
+    /*! entries, in image order */
+    dcid_index_entry_t entry[DCID_INDEX_MAX_ENTRIES];
+}
+dcid_index_t;
+
+/*! (re)build index from the shadow image, unless it is already current */
+int dcid_index_update(dcid_t *p_dcid);
+
+/*! look up a '/' separated tag path in an index */
+int dcid_index_find(const dcid_index_t *p_index, const char *path, const dcid_index_entry_t **pp_entry);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -8,6 +8,10 @@
 
 #include "dcid_interface.h"
 #include "dcid_utility.h"
+#include "dcid_index.h"
+#include "dcid_cache.h"
+#include "dcid_shm.h"
+#include "dcid_trace.h"
 
 #include <stdio.h>
 #include <stdint.h>
@@ -16,12 +20,108 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
-#include <ctype.h>
 
+/*! bounded output cursor used while rendering XML */
+typedef struct _xml_out_t
+{
+    /*! next character to be written */
+    char *cur;
+    /*! last usable character, which is reserved for the null terminator */
+    char *end;
+}
+xml_out_t;
+
+/*! utility function for appending to an XML output cursor */
+static int xml_out_put(xml_out_t *p_out, const char *str, int len);
+/*! utility function for appending indentation to an XML output cursor */
+static int xml_out_indent(xml_out_t *p_out, int depth);
 /*! utility function for recursively parsing XML tags */
-static int recursive_tag_parse(dcid_t *p_dcid, char *xml_data, int *p_cur_pos, int stop_pos, int depth);
-/*! utility function for recursively writing XML tags */
-static int recursive_tag_write(dcid_t *p_dcid, char **p_xml_data, int *p_cur_pos, char *lastTagRec);
+static int recursive_tag_parse(dcid_t *p_dcid, xml_out_t *p_out, int *p_cur_pos, int stop_pos, int depth);
+/*! \name XML character classes, used by the XML writer */
+/*! \{ */
+#define XML_HEX     0x10    /*!< hex digit, low nibble holds the digit value */
+#define XML_SPACE   0x20    /*!< whitespace */
+#define XML_OPEN    0x40    /*!< tag open */
+#define XML_CLOSE   0x80    /*!< tag close */
+#define XML_END     0xC0    /*!< null terminator, stops scans for either tag delimiter */
+/*! \} */
+
+/*! XML character class lookup table */
+static const uint8_t xml_char_class[256] =
+{
+    [0]    = XML_END,
+    ['0']  = XML_HEX|0x0, ['1'] = XML_HEX|0x1, ['2'] = XML_HEX|0x2, ['3'] = XML_HEX|0x3,
+    ['4']  = XML_HEX|0x4, ['5'] = XML_HEX|0x5, ['6'] = XML_HEX|0x6, ['7'] = XML_HEX|0x7,
+    ['8']  = XML_HEX|0x8, ['9'] = XML_HEX|0x9,
+    ['A']  = XML_HEX|0xA, ['B'] = XML_HEX|0xB, ['C'] = XML_HEX|0xC,
+    ['D']  = XML_HEX|0xD, ['E'] = XML_HEX|0xE, ['F'] = XML_HEX|0xF,
+    ['a']  = XML_HEX|0xA, ['b'] = XML_HEX|0xB, ['c'] = XML_HEX|0xC,
+    ['d']  = XML_HEX|0xD, ['e'] = XML_HEX|0xE, ['f'] = XML_HEX|0xF,
+    [' ']  = XML_SPACE, ['\t'] = XML_SPACE, ['\n'] = XML_SPACE,
+    ['\v'] = XML_SPACE, ['\f'] = XML_SPACE, ['\r'] = XML_SPACE,
+    ['<']  = XML_OPEN,
+    ['>']  = XML_CLOSE,
+};
+
+/*! \name XML writer states */
+/*! \{ */
+#define XML_W_TEXT      0   /*!< between tags, looking for the next one */
+#define XML_W_TAG       1   /*!< inside a tag, looking for its end */
+#define XML_W_OPENED    2   /*!< after an open tag, skipping whitespace up to its content */
+#define XML_W_HEX_HI    3   /*!< in leaf data, expecting the high digit of a byte */
+#define XML_W_HEX_LO    4   /*!< in leaf data, expecting the low digit of a byte */
+#define XML_W_DONE      5   /*!< past the end of the document, or failed */
+/*! \} */
+
+/*! one level of record nesting */
+typedef struct _xml_level_t
+{
+    /*! tag of the enclosing container, zero at the top level */
+    char parent_tag[4];
+    /*! tag the next close tag must match */
+    char last_tag[4];
+    /*! set after a leaf, whose close tag does not end this level */
+    int skip_end_tag;
+    /*! address of the enclosing container's size field */
+    int size_addr;
+}
+xml_level_t;
+
+/*! XML writer, which encodes a document into the write cache as it arrives, in chunks of
+ *  any size. nesting is tracked in levels[], so nothing lives on the C stack between chunks */
+typedef struct _dcid_writer_t
+{
+    /*! XML_W_ state */
+    int state;
+    /*! DCID_OK, or the first failure */
+    int result;
+    /*! next image address */
+    int cur_pos;
+    /*! current nesting level, index into levels */
+    int depth;
+    /*! address of the size field of the last record opened */
+    int open_addr;
+    /*! leading characters of the current tag, between '<' and '>' */
+    char tag[5];
+    /*! length of the current tag, which may run past tag[] */
+    int tag_len;
+    /*! high digit of the byte being decoded, as its xml_char_class entry */
+    uint8_t hex_hi;
+    /*! nesting levels, 0 being the top level */
+    xml_level_t levels[DCID_MAX_DEPTH+1];
+}
+dcid_writer_t;
+
+/*! utility function for starting an XML writer, staging the image header */
+static int xml_writer_begin(dcid_t *p_dcid, dcid_writer_t *p_writer);
+/*! utility function for encoding a chunk of XML into the write cache */
+static int xml_writer_feed(dcid_t *p_dcid, dcid_writer_t *p_writer, const char *xml_data, int size);
+/*! utility function for finishing an XML writer, closing open records and staging the image trailer */
+static int xml_writer_end(dcid_t *p_dcid, dcid_writer_t *p_writer);
+/*! utility function for rendering the shadow image as XML */
+static int decode_image(dcid_t *p_dcid, char *xml_data, int *p_size);
+/*! utility function for encoding XML into the write cache, returning the image size */
+static int encode_xml(dcid_t *p_dcid, char *xml_data, int *p_cur_pos);
 
 int dcid_create(struct _dcid_info_t *p_dcid_info, struct _dcid_t **pp_dcid)
 {
@@ -35,9 +135,34 @@ int dcid_create(struct _dcid_info_t *p_dcid_info, struct _dcid_t **pp_dcid)
     memset(p_dcid, 0, sizeof(dcid_t));
     /*! default state - invalid file */
     p_dcid->device_file = -1;
+    /*! default state - platform backend */
+    p_dcid->backend = dcid_backend_default();
+    /*! default state - dcid block not located */
+    p_dcid->block_offset = -1;
     /*! write cache - initially empty */
-    p_dcid->write_cache = (uint16_t*)malloc((DCID_MAX_ADDRESS+1)*sizeof(uint16_t));
-    memset(p_dcid->write_cache, 0, (DCID_MAX_ADDRESS+1)*sizeof(uint16_t));
+    p_dcid->write_cache = (uint8_t*)malloc(DCID_MAX_ADDRESS+1);
+    memset(p_dcid->write_cache, 0, DCID_MAX_ADDRESS+1);
+    /*! every position starts out staged as zero, so the first flush clears the rest of the card */
+    p_dcid->write_dirty = (uint32_t*)malloc(DCID_DIRTY_WORDS*sizeof(uint32_t));
+    memset(p_dcid->write_dirty, 0xFF, DCID_DIRTY_WORDS*sizeof(uint32_t));
+    /*! shadow image - initially not loaded */
+    p_dcid->image = (uint8_t*)malloc(DCID_MAX_RAW_SIZE);
+    memset(p_dcid->image, 0, DCID_MAX_RAW_SIZE);
+    /*! tag index - initially not built */
+    p_dcid->index = (dcid_index_t*)malloc(sizeof(dcid_index_t));
+    memset(p_dcid->index, 0, sizeof(dcid_index_t));
+    /*! write cycle completion limits */
+    p_dcid->write_poll_limit = DCID_DEFAULT_WRITE_POLL_LIMIT;
+    p_dcid->write_timeout_us = DCID_DEFAULT_WRITE_TIMEOUT_US;
+
+    /*! apply caller overrides */
+    if(p_dcid_info != 0)
+    {
+        if(p_dcid_info->write_poll_limit > 0) { p_dcid->write_poll_limit = p_dcid_info->write_poll_limit; }
+        if(p_dcid_info->write_timeout_us > 0) { p_dcid->write_timeout_us = p_dcid_info->write_timeout_us; }
+        if(p_dcid_info->cache_dir != 0) { p_dcid->cache_dir = strdup(p_dcid_info->cache_dir); }
+        if(p_dcid_info->backend != 0) { p_dcid->backend = p_dcid_info->backend; }
+    }
 
     /*! return allocated context */
     *pp_dcid = p_dcid;
@@ -50,6 +175,9 @@ int dcid_close(struct _dcid_t *p_dcid)
     /*! sanity check - null ptr */
     if(p_dcid == 0) { return DCID_INVALID_PARAM; }
 
+    /*! cleanup background flush, waiting for it to finish */
+    dcid_flush_destroy(p_dcid);
+
     /*! cleanup write cache */
     if(p_dcid->write_cache != 0)
     {
@@ -58,12 +186,73 @@ int dcid_close(struct _dcid_t *p_dcid)
         p_dcid->write_cache = 0;
     }
 
+    /*! cleanup dirty bitmap */
+    if(p_dcid->write_dirty != 0)
+    {
+        /*! free associated memory */
+        free(p_dcid->write_dirty);
+        p_dcid->write_dirty = 0;
+    }
+
+    /*! cleanup XML writer */
+    if(p_dcid->writer != 0)
+    {
+        /*! free associated memory */
+        free(p_dcid->writer);
+        p_dcid->writer = 0;
+    }
+
+    /*! cleanup shadow image */
+    if(p_dcid->image != 0)
+    {
+        /*! free associated memory */
+        free(p_dcid->image);
+        p_dcid->image = 0;
+    }
+
+    /*! cleanup tag index */
+    if(p_dcid->index != 0)
+    {
+        /*! free associated memory */
+        free(p_dcid->index);
+        p_dcid->index = 0;
+    }
+
+    /*! cleanup shared memory snapshot. the segment itself stays behind for readers */
+    if(p_dcid->shm != 0)
+    {
+        dcid_shm_detach(p_dcid->shm);
+        p_dcid->shm = 0;
+    }
+
+    /*! cleanup device operation trace */
+    if(p_dcid->trace != 0)
+    {
+        /*! free associated memory */
+        free(p_dcid->trace);
+        p_dcid->trace = 0;
+    }
+
+    /*! cleanup on-disk cache state */
+    if(p_dcid->cache_dir != 0)
+    {
+        /*! free associated memory */
+        free(p_dcid->cache_dir);
+        p_dcid->cache_dir = 0;
+    }
+
+    if(p_dcid->cache_xml != 0)
+    {
+        /*! free associated memory */
+        free(p_dcid->cache_xml);
+        p_dcid->cache_xml = 0;
+    }
+
     /*! cleanup dcid device file */
     if(p_dcid->device_file != -1)
     {
-        /*! close device device file */
-        close(p_dcid->device_file);
-        p_dcid->device_file = 0;
+        /*! close device through its backend */
+        p_dcid->backend->close(p_dcid);
     }
 
     /*! free associated context */
@@ -78,21 +267,10 @@ int dcid_init(struct _dcid_t *p_dcid, char *dcid_device_path)
     if(p_dcid == 0) { return DCID_INVALID_PARAM; }
 
     /*! attempt to open dcid device */
-    p_dcid->device_file = open(dcid_device_path, O_RDWR);
-    
-#if defined(CNPLATFORM_avlite)
-    if(p_dcid->device_file == -1) {
-        p_dcid->device_file = open(dcid_device_path, O_RDWR | O_CREAT, 0644);
-        if(p_dcid->device_file != -1) {
-            char data[2048];
-            bzero(data, sizeof(data));
-            write(p_dcid->device_file, data, sizeof(data));
-        }
-    }
-#endif    
+    int ret = p_dcid->backend->open(p_dcid, dcid_device_path);
 
     /*! failed to open dcid device */
-    if(p_dcid->device_file == -1) { return DCID_FAIL; }
+    if(DCID_FAILED(ret)) { return ret; }
 
     /*! we're all initialized now */
     p_dcid->is_initialized = 1;
@@ -108,11 +286,113 @@ int dcid_read_xml(struct _dcid_t *p_dcid, char *xml_data, int *p_size)
     /*! sanity check - null ptr */
     if(p_size == 0) { return DCID_INVALID_PARAM; }
 
-    int cur_pos = 0;
+    /*! sanity check - room for at least the null terminator */
+    if(xml_data == 0 || *p_size <= 0) { return DCID_BUFFER_TOO_SMALL; }
+
+    /*! let a background flush finish first */
+    dcid_flush_wait(p_dcid);
 
     /*! reset xml_data */
     xml_data[0] = '\0';
 
+    /*! a cache file for this card saves reading the whole image and decoding it. a miss is harmless */
+    if(p_dcid->cache_dir != 0 && p_dcid->cache_xml == 0 && !p_dcid->image_valid) { dcid_cache_load(p_dcid); }
+
+    /*! the on-disk cache already holds XML rendered from the card contents */
+    if(p_dcid->cache_xml != 0)
+    {
+        if(p_dcid->cache_xml_size > *p_size) { return DCID_BUFFER_TOO_SMALL; }
+
+        memcpy(xml_data, p_dcid->cache_xml, p_dcid->cache_xml_size);
+
+        *p_size = p_dcid->cache_xml_size;
+
+        return DCID_OK;
+    }
+
+    /*! fetch the whole image up front, so parsing works from memory */
+    {
+        int ret = dcid_util_load_image(p_dcid);
+
+        if(DCID_FAILED(ret)) { return ret; }
+    }
+
+    /*! render XML from the shadow image */
+    {
+        uint64_t beg = dcid_util_time_us();
+
+        int ret = decode_image(p_dcid, xml_data, p_size);
+
+        p_dcid->stats.parse_us += dcid_util_time_us() - beg;
+
+        if(DCID_FAILED(ret)) { return ret; }
+    }
+
+    /*! remember the result for next time, if caching is enabled. failure here is harmless */
+    if(p_dcid->cache_dir != 0) { dcid_cache_store(p_dcid, xml_data, *p_size); }
+
+    return DCID_OK;
+}
+
+int dcid_read_image(struct _dcid_t *p_dcid, uint8_t *raw_data, int *p_size)
+{
+    /*! sanity check - null ptr */
+    if(p_dcid == 0) { return DCID_INVALID_PARAM; }
+
+    /*! sanity check - null ptr */
+    if(p_size == 0 || raw_data == 0) { return DCID_INVALID_PARAM; }
+
+    /*! let a background flush finish first */
+    dcid_flush_wait(p_dcid);
+
+    /*! fetch image from device, if we have not done so already */
+    {
+        int ret = dcid_util_load_image(p_dcid);
+
+        if(DCID_FAILED(ret)) { return ret; }
+    }
+
+    /*! copy out as much as the caller can hold */
+    if(*p_size > DCID_MAX_RAW_SIZE) { *p_size = DCID_MAX_RAW_SIZE; }
+    if(*p_size < 0) { *p_size = 0; }
+
+    memcpy(raw_data, p_dcid->image, *p_size);
+
+    return DCID_OK;
+}
+
+int dcid_get(struct _dcid_t *p_dcid, const char *path, uint8_t *data, int *p_size)
+{
+    /*! sanity check - null ptr */
+    if(p_dcid == 0 || path == 0 || p_size == 0) { return DCID_INVALID_PARAM; }
+
+    /*! let a background flush finish first */
+    dcid_flush_wait(p_dcid);
+
+    /*! with the image in memory, resolve the path through the tag index */
+    if(p_dcid->image_valid && DCID_SUCCESS(dcid_index_update(p_dcid)))
+    {
+        const dcid_index_entry_t *p_entry = 0;
+
+        int ret = dcid_index_find(p_dcid->index, path, &p_entry);
+
+        if(DCID_FAILED(ret)) { return ret; }
+
+        if(*p_size < p_entry->size || (p_entry->size > 0 && data == 0))
+        {
+            *p_size = p_entry->size;
+            return DCID_BUFFER_TOO_SMALL;
+        }
+
+        *p_size = p_entry->size;
+
+        if(p_entry->size > 0) { memcpy(data, &p_dcid->image[p_entry->offset + DCID_RECORD_HDR_SIZE], p_entry->size); }
+
+        return DCID_OK;
+    }
+
+    int cur_pos = 0, end_pos = DCID_MAX_RAW_SIZE, depth = 0;
+
     /*! validate header */
     {
         int size = 4;
@@ -120,46 +400,101 @@ int dcid_read_xml(struct _dcid_t *p_dcid, char *xml_data, int *p_size)
         uint8_t hdr[4] = { 's', 'e', 'x', 'i' };
         uint8_t chk[4] = { 0 };
 
-        dcid_util_read_raw(p_dcid, cur_pos, chk, &size);
+        int ret = dcid_util_read_raw(p_dcid, cur_pos, chk, &size);
 
-        /*! fail if header validation failed */
-        if(memcmp(chk, hdr, 4) != 0)
-        {
-            return DCID_FAIL;
-        }
+        if(DCID_FAILED(ret)) { return ret; }
+
+        if(memcmp(chk, hdr, 4) != 0) { return DCID_FAIL; }
 
         cur_pos += 4;
     }
 
-    /*! obligatory XML version header */
-    strcat(xml_data, "<?xml version='1.0'?>\n");
+    /*! leading separator is optional */
+    if(*path == '/') { path++; }
 
-    /*! parse data blocks */
-    recursive_tag_parse(p_dcid, xml_data, &cur_pos, 0, 0);
-
-    /*! validate trailer */
+    while(1)
     {
-        int size = 4;
+        uint8_t rec[DCID_RECORD_HDR_SIZE];
 
-        uint8_t tlr[4] = { 'p', 'u', 's', '!' };
-        uint8_t chk[4] = { 0 };
+        int size = DCID_RECORD_HDR_SIZE, rec_size = 0;
 
-        dcid_util_read_raw(p_dcid, cur_pos, chk, &size);
+        /*! each path element is exactly one tag */
+        if(strlen(path) < 4 || (path[4] != '/' && path[4] != '\0')) { return DCID_INVALID_PARAM; }
 
-        if(memcmp(chk, tlr, 4) != 0)
+        /*! end of this nesting level */
+        if(cur_pos + DCID_RECORD_HDR_SIZE > end_pos) { return DCID_NOT_FOUND; }
+
+        /*! read record header only */
         {
-            return DCID_FAIL;
+            int ret = dcid_util_read_raw(p_dcid, cur_pos, rec, &size);
+
+            if(DCID_FAILED(ret)) { return ret; }
         }
 
-        cur_pos += 4;
+        /*! top level records run up to the trailer */
+        if(depth == 0 && memcmp(rec, "pus!", 4) == 0) { return DCID_NOT_FOUND; }
+
+        rec_size = rec[1] & 0x7F;
+
+        /*! record must fit inside its parent */
+        if(rec_size < DCID_RECORD_HDR_SIZE || cur_pos + rec_size > end_pos) { return DCID_FAIL; }
+
+        /*! skip over unrelated records, without reading their payload */
+        if(memcmp(&rec[2], path, 4) != 0)
+        {
+            cur_pos += rec_size;
+            continue;
+        }
+
+        /*! descend into matching container */
+        if(path[4] == '/')
+        {
+            if(!(rec[1] & 0x80)) { return DCID_NOT_FOUND; }
+
+            end_pos = cur_pos + rec_size;
+            cur_pos += DCID_RECORD_HDR_SIZE;
+            path += 5;
+            depth++;
+            continue;
+        }
+
+        /*! found it - hand back the payload */
+        size = rec_size - DCID_RECORD_HDR_SIZE;
+
+        if(*p_size < size || (size > 0 && data == 0))
+        {
+            *p_size = size;
+            return DCID_BUFFER_TOO_SMALL;
+        }
+
+        *p_size = size;
+
+        if(size == 0) { return DCID_OK; }
+
+        return dcid_util_read_raw(p_dcid, cur_pos + DCID_RECORD_HDR_SIZE, data, p_size);
     }
+}
 
-    *p_size = strlen(xml_data) + 1;
+int dcid_write_xml(struct _dcid_t *p_dcid, char *xml_data, int *p_size)
+{
+    /*! encode into the write cache */
+    {
+        int ret = dcid_stage_xml(p_dcid, xml_data, p_size);
+
+        if(DCID_FAILED(ret)) { return ret; }
+    }
+
+    /*! attempt to flush write cache */
+    {
+        int ret = dcid_util_write_flush(p_dcid);
+
+        if(DCID_FAILED(ret)) { return ret; }
+    }
 
     return DCID_OK;
 }
 
-int dcid_write_xml(struct _dcid_t *p_dcid, char *xml_data, int *p_size)
+int dcid_stage_xml(struct _dcid_t *p_dcid, char *xml_data, int *p_size)
 {
     /*! sanity check - null ptr */
     if(p_dcid == 0) { return DCID_INVALID_PARAM; }
@@ -167,62 +502,305 @@ int dcid_write_xml(struct _dcid_t *p_dcid, char *xml_data, int *p_size)
     /*! sanity check - null ptr */
     if(p_size == 0) { return DCID_INVALID_PARAM; }
 
+    /*! let a background flush finish first */
+    dcid_flush_wait(p_dcid);
+
+    /*! encode into the write cache */
+    {
+        int cur_pos = 0;
+
+        uint64_t beg = dcid_util_time_us();
+
+        int ret = encode_xml(p_dcid, xml_data, &cur_pos);
+
+        p_dcid->stats.encode_us += dcid_util_time_us() - beg;
+
+        if(DCID_FAILED(ret)) { return ret; }
+    }
+
+    return DCID_OK;
+}
+
+int dcid_write_flush(struct _dcid_t *p_dcid)
+{
+    /*! sanity check - null ptr */
+    if(p_dcid == 0) { return DCID_INVALID_PARAM; }
+
+    /*! let a background flush finish first */
+    dcid_flush_wait(p_dcid);
+
+    return dcid_util_write_flush(p_dcid);
+}
+
+int dcid_write_begin(struct _dcid_t *p_dcid)
+{
+    /*! sanity check - null ptr */
+    if(p_dcid == 0) { return DCID_INVALID_PARAM; }
+
+    /*! let a background flush finish first */
+    dcid_flush_wait(p_dcid);
+
+    /*! any document already in progress is abandoned */
+    if(p_dcid->writer == 0)
+    {
+        p_dcid->writer = (dcid_writer_t*)malloc(sizeof(dcid_writer_t));
+
+        if(p_dcid->writer == 0) { return DCID_OUT_OF_MEMORY; }
+    }
+
+    return xml_writer_begin(p_dcid, p_dcid->writer);
+}
+
+int dcid_write_feed(struct _dcid_t *p_dcid, const char *xml_data, int size)
+{
+    /*! sanity check - null ptr */
+    if(p_dcid == 0 || size < 0 || (xml_data == 0 && size > 0)) { return DCID_INVALID_PARAM; }
+
+    /*! sanity check - document in progress */
+    if(p_dcid->writer == 0) { return DCID_INVALID_CALL; }
+
+    /*! let a background flush finish first */
+    dcid_flush_wait(p_dcid);
+
+    uint64_t beg = dcid_util_time_us();
+
+    int ret = xml_writer_feed(p_dcid, p_dcid->writer, xml_data, size);
+
+    p_dcid->stats.encode_us += dcid_util_time_us() - beg;
+
+    return ret;
+}
+
+int dcid_write_end(struct _dcid_t *p_dcid, int flush)
+{
+    /*! sanity check - null ptr */
+    if(p_dcid == 0) { return DCID_INVALID_PARAM; }
+
+    /*! sanity check - document in progress */
+    if(p_dcid->writer == 0) { return DCID_INVALID_CALL; }
+
+    /*! let a background flush finish first */
+    dcid_flush_wait(p_dcid);
+
+    dcid_writer_t *p_writer = p_dcid->writer;
+
+    int ret = DCID_OK;
+
+    /*! a stream that stops inside a record was cut short, so it is refused rather than committed */
+    if(DCID_SUCCESS(p_writer->result) && p_writer->state != XML_W_DONE && (p_writer->depth > 0 || p_writer->state != XML_W_TEXT)) { ret = DCID_FAIL; }
+
+    if(DCID_SUCCESS(ret)) { ret = xml_writer_end(p_dcid, p_writer); }
+
+    free(p_dcid->writer);
+    p_dcid->writer = 0;
+
+    if(DCID_SUCCESS(ret) && flush) { ret = dcid_util_write_flush(p_dcid); }
+
+    return ret;
+}
+
+int dcid_get_stats(struct _dcid_t *p_dcid, struct _dcid_stats_t *p_stats)
+{
+    /*! sanity check - null ptr */
+    if(p_dcid == 0 || p_stats == 0) { return DCID_INVALID_PARAM; }
+
+    /*! let a background flush finish first */
+    dcid_flush_wait(p_dcid);
+
+    *p_stats = p_dcid->stats;
+
+    return DCID_OK;
+}
+
+int dcid_reset_stats(struct _dcid_t *p_dcid)
+{
+    /*! sanity check - null ptr */
+    if(p_dcid == 0) { return DCID_INVALID_PARAM; }
+
+    /*! let a background flush finish first */
+    dcid_flush_wait(p_dcid);
+
+    memset(&p_dcid->stats, 0, sizeof(p_dcid->stats));
+
+    return DCID_OK;
+}
+
+int dcid_encode_xml(const char *xml_data, uint8_t *raw_data, int *p_size)
+{
+    /*! sanity check - null ptr */
+    if(xml_data == 0 || raw_data == 0 || p_size == 0) { return DCID_INVALID_PARAM; }
+
+    /*! a private instance with nothing but a write cache behind it */
+    dcid_t dcid;
+    uint8_t cache[DCID_MAX_RAW_SIZE];
+    uint32_t dirty[DCID_DIRTY_WORDS];
+
+    memset(&dcid, 0, sizeof(dcid));
+    memset(cache, 0, sizeof(cache));
+    memset(dirty, 0, sizeof(dirty));
+
+    dcid.device_file = -1;
+    dcid.write_cache = cache;
+    dcid.write_dirty = dirty;
+
     int cur_pos = 0;
 
-    /*! write header */
+    int ret = encode_xml(&dcid, (char*)xml_data, &cur_pos);
+
+    if(DCID_FAILED(ret)) { return ret; }
+
+    if(cur_pos > *p_size) { *p_size = cur_pos; return DCID_BUFFER_TOO_SMALL; }
+
+    memcpy(raw_data, cache, cur_pos);
+
+    *p_size = cur_pos;
+
+    return DCID_OK;
+}
+
+int dcid_decode_image(const uint8_t *raw_data, int raw_size, char *xml_data, int *p_size)
+{
+    /*! sanity check - null ptr */
+    if(raw_data == 0 || p_size == 0) { return DCID_INVALID_PARAM; }
+
+    /*! sanity check - image must fit the device */
+    if(raw_size < 0 || raw_size > DCID_MAX_RAW_SIZE) { return DCID_INVALID_PARAM; }
+
+    /*! sanity check - room for at least the null terminator */
+    if(xml_data == 0 || *p_size <= 0) { return DCID_BUFFER_TOO_SMALL; }
+
+    /*! a private instance with the given image standing in for the device */
+    dcid_t dcid;
+    uint8_t image[DCID_MAX_RAW_SIZE];
+
+    memset(&dcid, 0, sizeof(dcid));
+    memset(image, 0, sizeof(image));
+    memcpy(image, raw_data, raw_size);
+
+    dcid.device_file = -1;
+    dcid.image = image;
+    dcid.image_valid = 1;
+
+    xml_data[0] = '\0';
+
+    return decode_image(&dcid, xml_data, p_size);
+}
+
+static int decode_image(dcid_t *p_dcid, char *xml_data, int *p_size)
+{
+    int cur_pos = 0;
+
+    xml_out_t out = { xml_data, xml_data + *p_size - 1 };
+
+    /*! validate header */
     {
         int size = 4;
 
         uint8_t hdr[4] = { 's', 'e', 'x', 'i' };
+        uint8_t chk[4] = { 0 };
 
-        int ret = dcid_util_write_raw(p_dcid, cur_pos, hdr, &size);
+        dcid_util_read_raw(p_dcid, cur_pos, chk, &size);
 
-        if(DCID_FAILED(ret)) { return ret; }
+        /*! fail if header validation failed */
+        if(memcmp(chk, hdr, 4) != 0)
+        {
+            return DCID_FAIL;
+        }
 
         cur_pos += 4;
     }
 
-    /*! recursively write tags */
+    /*! obligatory XML version header, and data blocks */
     {
-        int ret = recursive_tag_write(p_dcid, &xml_data, &cur_pos, "");
+        static const char xml_hdr[] = "<?xml version='1.0'?>\n";
+
+        int ret = xml_out_put(&out, xml_hdr, sizeof(xml_hdr)-1);
+
+        if(DCID_SUCCESS(ret)) { ret = recursive_tag_parse(p_dcid, &out, &cur_pos, 0, 0); }
+
+        /*! always leave a terminated string behind */
+        *out.cur = '\0';
 
         if(DCID_FAILED(ret)) { return ret; }
     }
 
-    /*! write trailer */
+    /*! validate trailer */
     {
         int size = 4;
 
         uint8_t tlr[4] = { 'p', 'u', 's', '!' };
+        uint8_t chk[4] = { 0 };
 
-        int ret = dcid_util_write_raw(p_dcid, cur_pos, tlr, &size);
+        dcid_util_read_raw(p_dcid, cur_pos, chk, &size);
 
-        if(DCID_FAILED(ret)) { return ret; }
+        if(memcmp(chk, tlr, 4) != 0)
+        {
+            return DCID_FAIL;
+        }
 
         cur_pos += 4;
     }
 
-    /*! attempt to flush write cache */
-    {
-        int ret = dcid_util_write_flush(p_dcid);
+    *p_size = (out.cur - xml_data) + 1;
 
-        if(DCID_FAILED(ret)) { return ret; }
-    }
+    return DCID_OK;
+}
+
+static int encode_xml(dcid_t *p_dcid, char *xml_data, int *p_cur_pos)
+{
+    dcid_writer_t writer;
+
+    int ret = xml_writer_begin(p_dcid, &writer);
+
+    if(DCID_SUCCESS(ret)) { ret = xml_writer_feed(p_dcid, &writer, xml_data, strlen(xml_data)); }
+    if(DCID_SUCCESS(ret)) { ret = xml_writer_end(p_dcid, &writer); }
+
+    if(DCID_FAILED(ret)) { return ret; }
+
+    *p_cur_pos = writer.cur_pos;
 
     return DCID_OK;
 }
 
-static int recursive_tag_parse(dcid_t *p_dcid, char *xml_data, int *p_cur_pos, int stop_pos, int depth)
+static int xml_out_put(xml_out_t *p_out, const char *str, int len)
 {
+    /*! refuse to overrun the caller's buffer */
+    if(len > (p_out->end - p_out->cur)) { return DCID_BUFFER_TOO_SMALL; }
+
+    memcpy(p_out->cur, str, len);
+
+    p_out->cur += len;
+
+    return DCID_OK;
+}
+
+static int xml_out_indent(xml_out_t *p_out, int depth)
+{
+    int len = depth*2;
+
+    /*! two spaces per level */
+    if(len > (p_out->end - p_out->cur)) { return DCID_BUFFER_TOO_SMALL; }
+
+    memset(p_out->cur, ' ', len);
+
+    p_out->cur += len;
+
+    return DCID_OK;
+}
+
+static int recursive_tag_parse(dcid_t *p_dcid, xml_out_t *p_out, int *p_cur_pos, int stop_pos, int depth)
+{
+    static const char hex_digits[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
+
     do
     {
         uint16_t tag_size = 0;
         char tag_name[5] = { 0 };
-        int rec = 0, v = 0;
+        int rec = 0, v = 0, name_len = 0, ret = DCID_OK;
 
         /*! read size */
         {
-            int ret = dcid_util_read_uint16(p_dcid, *p_cur_pos, &tag_size);
+            ret = dcid_util_read_uint16(p_dcid, *p_cur_pos, &tag_size);
 
             if(DCID_FAILED(ret)) { return ret; }
 
@@ -236,161 +814,361 @@ static int recursive_tag_parse(dcid_t *p_dcid, char *xml_data, int *p_cur_pos, i
         {
             int size = 4;
 
-            int ret = dcid_util_read_raw(p_dcid, *p_cur_pos, (uint8_t*)&tag_name, &size);
+            ret = dcid_util_read_raw(p_dcid, *p_cur_pos, (uint8_t*)&tag_name, &size);
 
             if(DCID_FAILED(ret)) { return ret; }
 
             *p_cur_pos += 4;
+
+            /*! tag names are null terminated early on blank cards */
+            while(name_len < 4 && tag_name[name_len] != '\0') { name_len++; }
         }
 
         /*! write out opening tag */
-        for(v=0;v<depth;v++) { strcat(xml_data, "  "); }
-        strcat(xml_data, "<");
-        strcat(xml_data, tag_name);
-        strcat(xml_data, ">");
+        ret = xml_out_indent(p_out, depth);
+        if(DCID_SUCCESS(ret)) { ret = xml_out_put(p_out, "<", 1); }
+        if(DCID_SUCCESS(ret)) { ret = xml_out_put(p_out, tag_name, name_len); }
+        if(DCID_SUCCESS(ret)) { ret = xml_out_put(p_out, ">", 1); }
+
+        if(DCID_FAILED(ret)) { return ret; }
 
         if(rec) 
         { 
-            strcat(xml_data, "\n"); 
-            recursive_tag_parse(p_dcid, xml_data, p_cur_pos, *p_cur_pos + tag_size - 6, depth+1);
+            ret = xml_out_put(p_out, "\n", 1);
+
+            if(DCID_SUCCESS(ret)) { ret = recursive_tag_parse(p_dcid, p_out, p_cur_pos, *p_cur_pos + tag_size - 6, depth+1); }
+
+            if(DCID_FAILED(ret)) { return ret; }
         }
         else
         {
-            /*! read data */
-            for(v=0;v<tag_size-6;v++)
-            {
-                uint8_t cur_byte;
+            uint8_t data[0x80];
 
-                int ret = dcid_util_read_byte(p_dcid, *p_cur_pos, &cur_byte);
+            int size = tag_size - 6;
+
+            /*! read data, in one shot */
+            if(size > 0)
+            {
+                ret = dcid_util_read_raw(p_dcid, *p_cur_pos, data, &size);
 
                 if(DCID_FAILED(ret)) { return ret; }
 
-                *p_cur_pos += 1;
+                *p_cur_pos += size;
+
+                /*! two hex digits per byte */
+                if(size*2 > (p_out->end - p_out->cur)) { return DCID_BUFFER_TOO_SMALL; }
 
-                char buff[3] = { 0 };
-                sprintf(buff, "%.02X", cur_byte);
-                strcat(xml_data, buff);
+                for(v=0;v<size;v++)
+                {
+                    *p_out->cur++ = hex_digits[data[v] >> 4];
+                    *p_out->cur++ = hex_digits[data[v] & 0x0F];
+                }
             }
         }
 
         /*! write out closing tag */
-        if(rec) { for(v=0;v<depth;v++) { strcat(xml_data, "  "); } }
-        strcat(xml_data, "</");
-        strcat(xml_data, tag_name);
-        strcat(xml_data, ">\n");
+        if(rec) { ret = xml_out_indent(p_out, depth); }
+        if(DCID_SUCCESS(ret)) { ret = xml_out_put(p_out, "</", 2); }
+        if(DCID_SUCCESS(ret)) { ret = xml_out_put(p_out, tag_name, name_len); }
+        if(DCID_SUCCESS(ret)) { ret = xml_out_put(p_out, ">\n", 2); }
+
+        if(DCID_FAILED(ret)) { return ret; }
     }
     while(*p_cur_pos < stop_pos);
 
     return DCID_OK;
 }
 
-static int recursive_tag_write(dcid_t *p_dcid, char **p_xml_data, int *p_cur_pos, char *lastTagRec)
+static int xml_writer_begin(dcid_t *p_dcid, dcid_writer_t *p_writer)
 {
-    /*! we need to remember the last tag in order to validate start and close tag syntax */
-    char lastTag[4] = { 0 };
-
-    int v, skip_end_tag = 0;
+    p_writer->state = XML_W_TEXT;
+    p_writer->result = DCID_OK;
+    p_writer->cur_pos = 0;
+    p_writer->depth = 0;
+    p_writer->open_addr = 0;
+    p_writer->tag_len = 0;
 
-    /*! remember last tag */
-    strncpy(lastTag, lastTagRec, 4);
+    /*! deeper levels are set up as they are entered */
+    memset(&p_writer->levels[0], 0, sizeof(xml_level_t));
 
-    while(1)
+    /*! write header */
     {
-        char *raw_tag_beg, *raw_tag_end;
+        int size = 4;
 
-        int size_addr = *p_cur_pos;
+        uint8_t hdr[4] = { 's', 'e', 'x', 'i' };
 
-        /*! end of XML data */
-        if((*p_xml_data)[0] == '\0') { break; }
+        int ret = dcid_util_write_raw(p_dcid, 0, hdr, &size);
 
-        /*! locate next tag */
-        raw_tag_beg = strchr(*p_xml_data, '<');
+        if(DCID_FAILED(ret)) { p_writer->result = ret; p_writer->state = XML_W_DONE; return ret; }
 
-        /*! if no begin tag was found, give up */
-        if(raw_tag_beg == 0) { break; }
+        p_writer->cur_pos = 4;
+    }
 
-        raw_tag_end = strchr(raw_tag_beg, '>');
+    return DCID_OK;
+}
 
-        /*! if no end tag was found, give up */
-        if(raw_tag_end == 0) { break; }
+/*! utility function for staging the size of a leaf, once its data has been decoded */
+static void xml_writer_leaf_end(dcid_t *p_dcid, dcid_writer_t *p_writer)
+{
+    dcid_util_write_uint16(p_dcid, p_writer->open_addr, (uint16_t)(p_writer->cur_pos - p_writer->open_addr));
 
-        /*! skip over <? tags */
-        if(raw_tag_beg[1] == '?') 
-        {
-            *p_xml_data = raw_tag_end + 1;
-            continue;
-        }
+    /*! the next close tag belongs to this leaf, rather than ending the level */
+    p_writer->levels[p_writer->depth].skip_end_tag = 1;
 
-        /*! finished with this level of recursion on close tag */
-        if(raw_tag_beg[1] == '/')
-        {
-            *p_xml_data = raw_tag_end + 1;
-            /*! detect mismatch between beginning/ending tags */
-            if(strncmp(&raw_tag_beg[2], lastTag, 4) != 0) { return DCID_FAIL; }
-            /*! detect if this should end this level of recursion, or just one tag */
-            if(skip_end_tag) { strncpy(lastTag, lastTagRec, 4); skip_end_tag = 0; continue; }
-            return DCID_OK; 
-        }
+    p_writer->state = XML_W_TEXT;
+}
+
+/*! utility function for descending into the record just opened, which is a container */
+static int xml_writer_push(dcid_writer_t *p_writer)
+{
+    /*! every level carries a record header, so deeper documents cannot fit the image */
+    if(p_writer->depth >= DCID_MAX_DEPTH) { return DCID_FAIL; }
+
+    xml_level_t *p_level = &p_writer->levels[p_writer->depth];
+    xml_level_t *p_child = &p_writer->levels[p_writer->depth+1];
+
+    memcpy(p_child->parent_tag, p_level->last_tag, 4);
+    memcpy(p_child->last_tag, p_level->last_tag, 4);
+
+    p_child->skip_end_tag = 0;
+    p_child->size_addr = p_writer->open_addr;
+
+    p_writer->depth++;
+    p_writer->state = XML_W_TEXT;
+
+    return DCID_OK;
+}
+
+/*! utility function for returning from a container, staging its size */
+static void xml_writer_pop(dcid_t *p_dcid, dcid_writer_t *p_writer)
+{
+    xml_level_t *p_level = &p_writer->levels[p_writer->depth--];
+    xml_level_t *p_parent = &p_writer->levels[p_writer->depth];
+
+    uint16_t chunk_size = (uint16_t)(p_writer->cur_pos - p_level->size_addr);
+
+    /*! tag this chunk as a container, if it holds any records */
+    if(p_writer->cur_pos > p_level->size_addr + DCID_RECORD_HDR_SIZE) { chunk_size |= 0x80; }
 
-        /*! ensure that this node name has exactly 4 characters */
-        if( (raw_tag_end - raw_tag_beg) != 5) { return DCID_FAIL; }
+    /*! restore correct last tag */
+    memcpy(p_parent->last_tag, p_parent->parent_tag, 4);
 
-        /*! skip over size field */
-        *p_cur_pos += 2;
+    dcid_util_write_uint16(p_dcid, p_level->size_addr, chunk_size);
+}
+
+/*! utility function for acting on a complete tag */
+static int xml_writer_tag(dcid_t *p_dcid, dcid_writer_t *p_writer)
+{
+    xml_level_t *p_level = &p_writer->levels[p_writer->depth];
+
+    int v;
+
+    p_writer->state = XML_W_TEXT;
+
+    /*! skip over <? tags */
+    if(p_writer->tag_len > 0 && p_writer->tag[0] == '?') { return DCID_OK; }
+
+    /*! close tag */
+    if(p_writer->tag_len > 0 && p_writer->tag[0] == '/')
+    {
+        /*! detect mismatch between beginning/ending tags */
+        if(p_writer->tag_len < 5 || memcmp(&p_writer->tag[1], p_level->last_tag, 4) != 0) { return DCID_FAIL; }
 
-        /*! parse tag name */
-        for(v=1;&raw_tag_beg[v] != raw_tag_end;v++)
+        /*! detect if this should end this level, or just one tag */
+        if(p_level->skip_end_tag)
         {
-            dcid_util_write_byte(p_dcid, (*p_cur_pos)++, raw_tag_beg[v]);
+            memcpy(p_level->last_tag, p_level->parent_tag, 4);
+            p_level->skip_end_tag = 0;
+            return DCID_OK;
         }
 
-        /*! remember last tag */
-        strncpy(lastTag, &raw_tag_beg[1], 4);
+        /*! nothing encloses the top level, so the document is complete */
+        if(p_writer->depth == 0) { p_writer->state = XML_W_DONE; return DCID_OK; }
+
+        xml_writer_pop(p_dcid, p_writer);
+
+        return DCID_OK;
+    }
 
-        /*! skip past tag end */
-        *p_xml_data = raw_tag_end + 1;
+    /*! ensure that this node name has exactly 4 characters */
+    if(p_writer->tag_len != 4) { return DCID_FAIL; }
 
-        /*! throw away all whitespace */
-        while(isspace(**p_xml_data)) { (*p_xml_data)++; }
+    p_writer->open_addr = p_writer->cur_pos;
 
-        uint16_t chunk_size = 0;
+    /*! skip over size field, staged once the record ends */
+    p_writer->cur_pos += 2;
+
+    /*! parse tag name */
+    for(v=0;v<4;v++) { dcid_util_write_byte(p_dcid, p_writer->cur_pos++, p_writer->tag[v]); }
+
+    /*! remember last tag */
+    memcpy(p_level->last_tag, p_writer->tag, 4);
 
-        /*! if we have hex data, this is not a container */
-        if(isxdigit(**p_xml_data))
+    p_writer->state = XML_W_OPENED;
+
+    return DCID_OK;
+}
+
+static int xml_writer_feed(dcid_t *p_dcid, dcid_writer_t *p_writer, const char *xml_data, int size)
+{
+    const char *xml = xml_data, *end = xml_data + size;
+
+    int ret = DCID_OK;
+
+    while(xml < end && p_writer->state != XML_W_DONE)
+    {
+        switch(p_writer->state)
         {
-            unsigned int cur_byte = 0;
+            case XML_W_TEXT:
+            {
+                /*! locate next tag */
+                while(xml < end && !(xml_char_class[(uint8_t)*xml] & XML_OPEN)) { xml++; }
+
+                if(xml == end) { break; }
 
-            while(sscanf(*p_xml_data, "%02X", &cur_byte) == 1)
+                /*! the null terminator ends the document */
+                if(*xml == '\0') { p_writer->state = XML_W_DONE; break; }
+
+                p_writer->tag_len = 0;
+                p_writer->state = XML_W_TAG;
+
+                xml++;
+            }
+            break;
+
+            case XML_W_TAG:
             {
-                dcid_util_write_byte(p_dcid, (*p_cur_pos)++, cur_byte);
-                *p_xml_data += 2;
+                int tag_len = p_writer->tag_len;
+
+                /*! gather the tag up to its end, keeping only its leading characters */
+                while(xml < end && !(xml_char_class[(uint8_t)*xml] & XML_CLOSE))
+                {
+                    if(tag_len < (int)sizeof(p_writer->tag)) { p_writer->tag[tag_len] = *xml; }
+
+                    tag_len++;
+
+                    xml++;
+                }
+
+                p_writer->tag_len = tag_len;
+
+                if(xml == end) { break; }
+
+                /*! the null terminator ends the document, taking the unfinished tag with it */
+                if(*xml == '\0') { p_writer->state = XML_W_DONE; break; }
+
+                xml++;
+
+                ret = xml_writer_tag(p_dcid, p_writer);
             }
+            break;
 
-            skip_end_tag = 1;
+            case XML_W_OPENED:
+            {
+                /*! throw away all whitespace */
+                while(xml < end && (xml_char_class[(uint8_t)*xml] & XML_SPACE)) { xml++; }
 
-            chunk_size = (uint16_t)(*p_cur_pos - size_addr);
-        }
-        else
-        {
-            /*! remember last position, because if we have not found any more tags, we
-             *  do not want to set the recursive flag for this node */
-            int last_pos = *p_cur_pos;
+                if(xml == end) { break; }
 
-            int ret = recursive_tag_write(p_dcid, p_xml_data, p_cur_pos, lastTag);
+                /*! if we have hex data, this is not a container */
+                if(xml_char_class[(uint8_t)*xml] & XML_HEX) { p_writer->state = XML_W_HEX_HI; break; }
 
-            if(DCID_FAILED(ret)) { return ret; }
+                ret = xml_writer_push(p_writer);
+            }
+            break;
+
+            case XML_W_HEX_LO:
+            {
+                /*! the previous chunk ended between the digits of a pair */
+                uint8_t lo = xml_char_class[(uint8_t)*xml];
+
+                p_writer->state = XML_W_HEX_HI;
+
+                /*! a lone trailing digit is taken as the whole byte value */
+                if(!(lo & XML_HEX))
+                {
+                    dcid_util_write_byte(p_dcid, p_writer->cur_pos++, p_writer->hex_hi & 0x0F);
+                    xml_writer_leaf_end(p_dcid, p_writer);
+                    break;
+                }
+
+                dcid_util_write_byte(p_dcid, p_writer->cur_pos++, ((p_writer->hex_hi & 0x0F) << 4) | (lo & 0x0F));
+
+                xml++;
+            }
+            break;
+
+            case XML_W_HEX_HI:
+            {
+                /*! decode hex pairs, skipping whitespace between them */
+                while(xml < end)
+                {
+                    uint8_t hi = xml_char_class[(uint8_t)*xml], lo;
+
+                    if(hi & XML_SPACE) { xml++; continue; }
+
+                    if(!(hi & XML_HEX)) { xml_writer_leaf_end(p_dcid, p_writer); break; }
+
+                    /*! the pair continues in the next chunk */
+                    if(xml+1 == end) { p_writer->hex_hi = hi; p_writer->state = XML_W_HEX_LO; xml++; break; }
 
-            /*! restore correct lastTag */
-            strncpy(lastTag, lastTagRec, 4);
+                    lo = xml_char_class[(uint8_t)xml[1]];
 
-            chunk_size = (uint16_t)(*p_cur_pos - size_addr);
+                    /*! a lone trailing digit is taken as the whole byte value */
+                    if(!(lo & XML_HEX))
+                    {
+                        dcid_util_write_byte(p_dcid, p_writer->cur_pos++, hi & 0x0F);
+                        xml_writer_leaf_end(p_dcid, p_writer);
+                        xml++;
+                        break;
+                    }
 
-            /*! tag this chunk as a container, if appropriate */
-            if(*p_cur_pos > last_pos) { chunk_size |= 0x80; }
+                    dcid_util_write_byte(p_dcid, p_writer->cur_pos++, ((hi & 0x0F) << 4) | (lo & 0x0F));
+
+                    xml += 2;
+                }
+            }
+            break;
         }
 
-        /*! write size field */
-        dcid_util_write_uint16(p_dcid, size_addr, chunk_size);
+        if(DCID_FAILED(ret)) { p_writer->result = ret; p_writer->state = XML_W_DONE; }
+    }
+
+    return p_writer->result;
+}
+
+static int xml_writer_end(dcid_t *p_dcid, dcid_writer_t *p_writer)
+{
+    if(DCID_FAILED(p_writer->result)) { return p_writer->result; }
+
+    /*! the document ended inside a record, which is finished as a null terminator would */
+    if(p_writer->state == XML_W_HEX_LO) { dcid_util_write_byte(p_dcid, p_writer->cur_pos++, p_writer->hex_hi & 0x0F); }
+
+    if(p_writer->state == XML_W_HEX_HI || p_writer->state == XML_W_HEX_LO) { xml_writer_leaf_end(p_dcid, p_writer); }
+
+    if(p_writer->state == XML_W_OPENED)
+    {
+        int ret = xml_writer_push(p_writer);
+
+        if(DCID_FAILED(ret)) { return ret; }
+    }
+
+    /*! close containers left open */
+    while(p_writer->depth > 0) { xml_writer_pop(p_dcid, p_writer); }
+
+    p_writer->state = XML_W_DONE;
+
+    /*! write trailer */
+    {
+        int size = 4;
+
+        uint8_t tlr[4] = { 'p', 'u', 's', '!' };
+
+        int ret = dcid_util_write_raw(p_dcid, p_writer->cur_pos, tlr, &size);
+
+        if(DCID_FAILED(ret)) { return ret; }
+
+        p_writer->cur_pos += 4;
     }
 
     return DCID_OK;
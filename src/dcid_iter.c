@@ -0,0 +1,155 @@
+/*
+ * dcid_iter.c
+ *
+ * dcid contributors
+ * (c) Copyright 2026
+ * All rights reserved
+ *
+ * This module implements in place iteration over the records of a DCID image.
+ */
+
+#include "dcid_interface.h"
+#include "dcid_utility.h"
+
+#include <string.h>
+
+/*! image header and trailer */
+static const uint8_t iter_hdr[4] = { 's', 'e', 'x', 'i' };
+static const uint8_t iter_tlr[4] = { 'p', 'u', 's', '!' };
+
+/*! utility function for decoding the record header at p_iter->offset */
+static int iter_load(dcid_iter_t *p_iter)
+{
+    const uint8_t *rec = &p_iter->image[p_iter->offset];
+
+    /*! top level records run up to the trailer */
+    if(p_iter->depth == 0)
+    {
+        if(p_iter->offset + 4 > p_iter->end) { return DCID_FAIL; }
+
+        if(memcmp(rec, iter_tlr, 4) == 0) { return DCID_NOT_FOUND; }
+    }
+
+    /*! end of this nesting level */
+    if(p_iter->offset >= p_iter->end) { return DCID_NOT_FOUND; }
+
+    /*! header must fit */
+    if(p_iter->offset + DCID_RECORD_HDR_SIZE > p_iter->end) { return DCID_FAIL; }
+
+    int size = rec[1] & 0x7F;
+
+    /*! record must fit inside its parent */
+    if(size < DCID_RECORD_HDR_SIZE || p_iter->offset + size > p_iter->end) { return DCID_FAIL; }
+
+    p_iter->tag = (const char*)&rec[2];
+    p_iter->data = &rec[DCID_RECORD_HDR_SIZE];
+    p_iter->size = size - DCID_RECORD_HDR_SIZE;
+    p_iter->is_container = (rec[1] & 0x80) ? 1 : 0;
+
+    return DCID_OK;
+}
+
+int dcid_iter_begin(struct _dcid_t *p_dcid, struct _dcid_iter_t *p_iter)
+{
+    /*! sanity check - null ptr */
+    if(p_dcid == 0 || p_iter == 0) { return DCID_INVALID_PARAM; }
+
+    /*! let a background flush finish first */
+    dcid_flush_wait(p_dcid);
+
+    /*! fetch image from device, if we have not done so already */
+    {
+        int ret = dcid_util_load_image(p_dcid);
+
+        if(DCID_FAILED(ret)) { return ret; }
+    }
+
+    /*! validate header */
+    if(memcmp(p_dcid->image, iter_hdr, 4) != 0) { return DCID_FAIL; }
+
+    memset(p_iter, 0, sizeof(dcid_iter_t));
+
+    p_iter->image = p_dcid->image;
+    p_iter->offset = 4;
+    p_iter->end = DCID_MAX_RAW_SIZE;
+
+    return iter_load(p_iter);
+}
+
+int dcid_iter_next(struct _dcid_iter_t *p_iter)
+{
+    /*! sanity check - null ptr */
+    if(p_iter == 0 || p_iter->tag == 0) { return DCID_INVALID_PARAM; }
+
+    int offset = p_iter->offset;
+
+    p_iter->offset += p_iter->size + DCID_RECORD_HDR_SIZE;
+
+    int ret = iter_load(p_iter);
+
+    /*! stay on the last good record */
+    if(DCID_FAILED(ret))
+    {
+        p_iter->offset = offset;
+        iter_load(p_iter);
+    }
+
+    return ret;
+}
+
+int dcid_iter_enter(struct _dcid_iter_t *p_iter)
+{
+    /*! sanity check - null ptr */
+    if(p_iter == 0 || p_iter->tag == 0) { return DCID_INVALID_PARAM; }
+
+    /*! only containers can be entered */
+    if(!p_iter->is_container) { return DCID_INVALID_CALL; }
+
+    if(p_iter->size == 0) { return DCID_NOT_FOUND; }
+
+    if(p_iter->depth >= DCID_MAX_DEPTH) { return DCID_FAIL; }
+
+    int offset = p_iter->offset, end = p_iter->end;
+
+    p_iter->parent[p_iter->depth++] = offset;
+    p_iter->end = offset + DCID_RECORD_HDR_SIZE + p_iter->size;
+    p_iter->offset = offset + DCID_RECORD_HDR_SIZE;
+
+    int ret = iter_load(p_iter);
+
+    /*! stay on the container */
+    if(DCID_FAILED(ret))
+    {
+        p_iter->depth--;
+        p_iter->offset = offset;
+        p_iter->end = end;
+        iter_load(p_iter);
+    }
+
+    return ret;
+}
+
+int dcid_iter_leave(struct _dcid_iter_t *p_iter)
+{
+    /*! sanity check - null ptr */
+    if(p_iter == 0 || p_iter->tag == 0) { return DCID_INVALID_PARAM; }
+
+    /*! nothing to leave at top level */
+    if(p_iter->depth == 0) { return DCID_INVALID_CALL; }
+
+    p_iter->offset = p_iter->parent[--p_iter->depth];
+
+    /*! restore end of the enclosing level */
+    if(p_iter->depth == 0)
+    {
+        p_iter->end = DCID_MAX_RAW_SIZE;
+    }
+    else
+    {
+        const uint8_t *rec = &p_iter->image[p_iter->parent[p_iter->depth-1]];
+
+        p_iter->end = p_iter->parent[p_iter->depth-1] + (rec[1] & 0x7F);
+    }
+
+    return iter_load(p_iter);
+}
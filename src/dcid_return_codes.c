@@ -11,7 +11,7 @@
 
 #include "dcid_interface.h"
 
-char *DCID_RETURN_CODE_LOOKUP[0x07] =
+char *DCID_RETURN_CODE_LOOKUP[0x0A] =
 {
     "DCID_OK",
     "DCID_FAIL",
@@ -19,5 +19,8 @@ char *DCID_RETURN_CODE_LOOKUP[0x07] =
     "DCID_INVALID_PARAM",
     "DCID_OUT_OF_MEMORY",
     "DCID_ACCESS_DENIED",
-    "DCID_INVALID_CALL"
+    "DCID_INVALID_CALL",
+    "DCID_BUFFER_TOO_SMALL",
+    "DCID_NOT_FOUND",
+    "DCID_CANCELLED"
 };
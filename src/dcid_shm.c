@@ -0,0 +1,304 @@
+/*
+ * dcid_shm.c
+ *
+ * dcid contributors
+ * (c) Copyright 2026
+ * All rights reserved
+ *
+ * This module implements the shared memory snapshot of the DCID image.
+ */
+
+#include "dcid_shm.h"
+#include "dcid_utility.h"
+#include "dcid_index.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sched.h>
+
+/*! snapshot layout version, bumped whenever dcid_shm_t changes */
+#define DCID_SHM_VERSION 1
+
+/*! attempts at a consistent copy before a reader gives up on the publisher */
+#define DCID_SHM_MAX_RETRIES 10000
+
+/*!
+
+  @brief DCID shared memory snapshot
+
+  Layout of the shared memory segment. Only the publisher writes to it.
+
+*/
+
+typedef struct _dcid_shm_t
+{
+    /*! segment magic, "dcsm" */
+    char magic[4];
+    /*! layout version, DCID_SHM_VERSION */
+    uint32_t version;
+    /*! generation counter, odd while an update is in progress */
+    volatile uint32_t generation;
+    /*! non-zero if image and index hold valid card contents */
+    uint32_t valid;
+    /*! device image */
+    uint8_t image[DCID_MAX_RAW_SIZE];
+    /*! tag index over image */
+    dcid_index_t index;
+}
+dcid_shm_t;
+
+/*! private copy of a snapshot, taken by readers */
+typedef struct _dcid_shm_copy_t
+{
+    uint32_t valid;
+    uint8_t image[DCID_MAX_RAW_SIZE];
+    dcid_index_t index;
+}
+dcid_shm_copy_t;
+
+/*! utility function for copying a consistent view of the snapshot */
+static int shm_copy(const dcid_shm_t *p_shm, dcid_shm_copy_t *p_copy, int with_index)
+{
+    int retry;
+
+    for(retry=0;retry<DCID_SHM_MAX_RETRIES;retry++)
+    {
+        uint32_t generation = p_shm->generation;
+
+        /*! update in progress */
+        if(generation & 1) { sched_yield(); continue; }
+
+        __sync_synchronize();
+
+        p_copy->valid = p_shm->valid;
+
+        memcpy(p_copy->image, p_shm->image, sizeof(p_copy->image));
+
+        if(with_index) { memcpy(&p_copy->index, &p_shm->index, sizeof(p_copy->index)); }
+
+        __sync_synchronize();
+
+        if(p_shm->generation == generation) { return DCID_OK; }
+    }
+
+    /*! publisher died mid-update, or never stops updating */
+    return DCID_FAIL;
+}
+
+int dcid_shm_update(dcid_t *p_dcid)
+{
+    dcid_shm_t *p_shm = p_dcid->shm;
+
+    if(p_shm == 0) { return DCID_INVALID_CALL; }
+
+    /*! refresh image and index, if they are not current */
+    int ret = dcid_util_load_image(p_dcid);
+
+    if(DCID_SUCCESS(ret)) { ret = dcid_index_update(p_dcid); }
+
+    p_shm->generation++;
+
+    __sync_synchronize();
+
+    if(DCID_SUCCESS(ret))
+    {
+        memcpy(p_shm->image, p_dcid->image, DCID_MAX_RAW_SIZE);
+        memcpy(&p_shm->index, p_dcid->index, sizeof(dcid_index_t));
+    }
+
+    /*! readers see the card as unreadable, rather than stale contents */
+    p_shm->valid = DCID_SUCCESS(ret);
+
+    __sync_synchronize();
+
+    p_shm->generation++;
+
+    return ret;
+}
+
+int dcid_shm_publish(struct _dcid_t *p_dcid, const char *shm_path)
+{
+    /*! sanity check - null ptr */
+    if(p_dcid == 0) { return DCID_INVALID_PARAM; }
+
+    /*! let a background flush finish first */
+    dcid_flush_wait(p_dcid);
+
+    /*! already published */
+    if(p_dcid->shm != 0) { return DCID_INVALID_CALL; }
+
+    if(shm_path == 0) { shm_path = DCID_SHM_PATH; }
+
+    struct stat st;
+
+    /*! never follow a link planted in a shared directory such as /dev/shm */
+    int fd = open(shm_path, O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0644);
+
+    if(fd == -1) { return DCID_ACCESS_DENIED; }
+
+    /*! a segment left by another user, or a hard link to some other file, is not ours to write */
+    if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_uid != geteuid() || st.st_nlink != 1)
+    {
+        close(fd);
+        return DCID_ACCESS_DENIED;
+    }
+
+    /*! anyone may read the snapshot, but nobody else may change it */
+    if(fchmod(fd, 0644) != 0 || ftruncate(fd, sizeof(dcid_shm_t)) != 0)
+    {
+        close(fd);
+        return DCID_FAIL;
+    }
+
+    dcid_shm_t *p_shm = (dcid_shm_t*)mmap(0, sizeof(dcid_shm_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if(p_shm == MAP_FAILED) { return DCID_FAIL; }
+
+    /*! continue from any generation left behind by an earlier publisher, so readers notice the change */
+    if(memcmp(p_shm->magic, "dcsm", 4) != 0 || p_shm->version != DCID_SHM_VERSION) { p_shm->generation = 0; }
+
+    p_shm->generation |= 1;
+
+    __sync_synchronize();
+
+    memcpy(p_shm->magic, "dcsm", 4);
+    p_shm->version = DCID_SHM_VERSION;
+    p_shm->valid = 0;
+
+    __sync_synchronize();
+
+    p_shm->generation++;
+
+    p_dcid->shm = p_shm;
+
+    /*! an unreadable card is published as such, and picked up again by the next write */
+    dcid_shm_update(p_dcid);
+
+    return DCID_OK;
+}
+
+int dcid_shm_attach(const char *shm_path, struct _dcid_shm_t **pp_shm)
+{
+    struct stat st;
+
+    /*! sanity check - null ptr */
+    if(pp_shm == 0) { return DCID_INVALID_PARAM; }
+
+    if(shm_path == 0) { shm_path = DCID_SHM_PATH; }
+
+    int fd = open(shm_path, O_RDONLY | O_CLOEXEC);
+
+    if(fd == -1) { return DCID_NOT_FOUND; }
+
+    /*! card data is only taken from a snapshot published by root (or by this user) */
+    if(fstat(fd, &st) != 0 || (st.st_uid != 0 && st.st_uid != geteuid()))
+    {
+        close(fd);
+        return DCID_ACCESS_DENIED;
+    }
+
+    /*! a segment left by a different layout is not ours to read */
+    if(fstat(fd, &st) != 0 || st.st_size != sizeof(dcid_shm_t))
+    {
+        close(fd);
+        return DCID_NOT_FOUND;
+    }
+
+    dcid_shm_t *p_shm = (dcid_shm_t*)mmap(0, sizeof(dcid_shm_t), PROT_READ, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if(p_shm == MAP_FAILED) { return DCID_FAIL; }
+
+    if(memcmp(p_shm->magic, "dcsm", 4) != 0 || p_shm->version != DCID_SHM_VERSION)
+    {
+        munmap(p_shm, sizeof(dcid_shm_t));
+        return DCID_NOT_FOUND;
+    }
+
+    *pp_shm = p_shm;
+
+    return DCID_OK;
+}
+
+int dcid_shm_detach(struct _dcid_shm_t *p_shm)
+{
+    /*! sanity check - null ptr */
+    if(p_shm == 0) { return DCID_INVALID_PARAM; }
+
+    munmap(p_shm, sizeof(dcid_shm_t));
+
+    return DCID_OK;
+}
+
+int dcid_shm_generation(struct _dcid_shm_t *p_shm, uint32_t *p_generation)
+{
+    int retry;
+
+    /*! sanity check - null ptr */
+    if(p_shm == 0 || p_generation == 0) { return DCID_INVALID_PARAM; }
+
+    for(retry=0;retry<DCID_SHM_MAX_RETRIES;retry++)
+    {
+        uint32_t generation = p_shm->generation;
+
+        if((generation & 1) == 0) { *p_generation = generation; return DCID_OK; }
+
+        sched_yield();
+    }
+
+    return DCID_FAIL;
+}
+
+int dcid_shm_read_image(struct _dcid_shm_t *p_shm, uint8_t *raw_data, int *p_size)
+{
+    dcid_shm_copy_t copy;
+
+    /*! sanity check - null ptr */
+    if(p_shm == 0 || raw_data == 0 || p_size == 0) { return DCID_INVALID_PARAM; }
+
+    if(DCID_FAILED(shm_copy(p_shm, &copy, 0)) || !copy.valid) { return DCID_FAIL; }
+
+    int size = (*p_size < DCID_MAX_RAW_SIZE) ? *p_size : DCID_MAX_RAW_SIZE;
+
+    if(size > 0) { memcpy(raw_data, copy.image, size); }
+
+    *p_size = size;
+
+    return DCID_OK;
+}
+
+int dcid_shm_get(struct _dcid_shm_t *p_shm, const char *path, uint8_t *data, int *p_size)
+{
+    const dcid_index_entry_t *p_entry = 0;
+    dcid_shm_copy_t copy;
+
+    /*! sanity check - null ptr */
+    if(p_shm == 0 || path == 0 || p_size == 0) { return DCID_INVALID_PARAM; }
+
+    /*! the index is walked on a private copy, since a torn view could send it anywhere */
+    if(DCID_FAILED(shm_copy(p_shm, &copy, 1)) || !copy.valid) { return DCID_FAIL; }
+
+    int ret = dcid_index_find(&copy.index, path, &p_entry);
+
+    if(DCID_FAILED(ret)) { return ret; }
+
+    if(*p_size < p_entry->size || (p_entry->size > 0 && data == 0))
+    {
+        *p_size = p_entry->size;
+        return DCID_BUFFER_TOO_SMALL;
+    }
+
+    *p_size = p_entry->size;
+
+    if(p_entry->size > 0) { memcpy(data, &copy.image[p_entry->offset + DCID_RECORD_HDR_SIZE], p_entry->size); }
+
+    return DCID_OK;
+}
@@ -0,0 +1,152 @@
+/*
+ * dcid_trace.c
+ *
+ * dcid contributors
+ * (c) Copyright 2026
+ * All rights reserved
+ *
+ * This module implements the device operation trace. See dcid_trace.h.
+ */
+
+#include "dcid_trace.h"
+#include "dcid_utility.h"
+
+#include <string.h>
+#include <malloc.h>
+
+/*!
+
+  @brief DCID trace ring
+
+*/
+
+typedef struct _dcid_trace_t
+{
+    /*! ring size, in entries */
+    int capacity;
+    /*! entries recorded since enabled, including those overwritten */
+    uint32_t recorded;
+    /*! ring storage */
+    dcid_trace_entry_t entries[1];
+}
+dcid_trace_t;
+
+int dcid_trace_enable(struct _dcid_t *p_dcid, int entries)
+{
+    /*! sanity check - null ptr */
+    if(p_dcid == 0 || entries < 0) { return DCID_INVALID_PARAM; }
+
+    /*! let a background flush finish first */
+    dcid_flush_wait(p_dcid);
+
+    if(p_dcid->trace != 0)
+    {
+        free(p_dcid->trace);
+        p_dcid->trace = 0;
+    }
+
+    if(entries == 0) { return DCID_OK; }
+
+    dcid_trace_t *p_trace = (dcid_trace_t*)malloc(sizeof(dcid_trace_t) + (entries-1)*sizeof(dcid_trace_entry_t));
+
+    if(p_trace == 0) { return DCID_OUT_OF_MEMORY; }
+
+    p_trace->capacity = entries;
+    p_trace->recorded = 0;
+
+    p_dcid->trace = p_trace;
+
+    return DCID_OK;
+}
+
+int dcid_trace_read(struct _dcid_t *p_dcid, struct _dcid_trace_entry_t *entries, int *p_count)
+{
+    /*! sanity check - null ptr */
+    if(p_dcid == 0 || p_count == 0 || (entries == 0 && *p_count > 0)) { return DCID_INVALID_PARAM; }
+
+    /*! let a background flush finish first */
+    dcid_flush_wait(p_dcid);
+
+    dcid_trace_t *p_trace = p_dcid->trace;
+
+    if(p_trace == 0) { return DCID_INVALID_CALL; }
+
+    /*! number of entries still held in the ring */
+    int held = (p_trace->recorded < (uint32_t)p_trace->capacity) ? (int)p_trace->recorded : p_trace->capacity;
+    int count = (held < *p_count) ? held : *p_count;
+    int v;
+
+    /*! newest entries win when the caller has less room than the ring */
+    uint32_t first = p_trace->recorded - count;
+
+    for(v=0;v<count;v++) { entries[v] = p_trace->entries[(first + v) % p_trace->capacity]; }
+
+    *p_count = count;
+
+    return DCID_OK;
+}
+
+int dcid_trace_dump(struct _dcid_t *p_dcid, FILE *out)
+{
+    static const char *event_names[] = { "?", "read", "write", "poll", "sleep", "sync", "ctrl" };
+
+    /*! sanity check - null ptr */
+    if(p_dcid == 0 || out == 0) { return DCID_INVALID_PARAM; }
+
+    /*! let a background flush finish first */
+    dcid_flush_wait(p_dcid);
+
+    dcid_trace_t *p_trace = p_dcid->trace;
+
+    if(p_trace == 0) { return DCID_INVALID_CALL; }
+
+    int count = p_trace->capacity;
+    int v;
+
+    dcid_trace_entry_t *entries = (dcid_trace_entry_t*)malloc(count*sizeof(dcid_trace_entry_t));
+
+    if(entries == 0) { return DCID_OUT_OF_MEMORY; }
+
+    dcid_trace_read(p_dcid, entries, &count);
+
+    if(p_trace->recorded > (uint32_t)count)
+    {
+        fprintf(out, "(%u earlier operations overwritten)\n", p_trace->recorded - count);
+    }
+
+    fprintf(out, "   time_us     dur_us  event   addr        size  primitive   result\n");
+
+    for(v=0;v<count;v++)
+    {
+        const dcid_trace_entry_t *p_entry = &entries[v];
+
+        const char *event = (p_entry->event < sizeof(event_names)/sizeof(event_names[0])) ? event_names[p_entry->event] : "?";
+        const char *result = (p_entry->result <= DCID_CANCELLED) ? DCID_RETURN_CODE_LOOKUP[p_entry->result] : "?";
+
+        fprintf(out, "%10.3f %10.3f  %-6s  0x%.08llX %6d  %-10s  %s\n",
+                (p_entry->time_ns - entries[0].time_ns)/1000.0, p_entry->duration_ns/1000.0,
+                event, (unsigned long long)p_entry->addr, p_entry->size,
+                p_entry->primitive ? p_entry->primitive : "", result);
+    }
+
+    free(entries);
+
+    return DCID_OK;
+}
+
+void dcid_trace_record(dcid_t *p_dcid, int event, int64_t addr, int size, const char *primitive, uint64_t beg_ns, int result)
+{
+    dcid_trace_t *p_trace = p_dcid->trace;
+
+    dcid_trace_entry_t *p_entry = &p_trace->entries[p_trace->recorded % p_trace->capacity];
+
+    p_entry->time_ns = beg_ns;
+    p_entry->duration_ns = (uint32_t)(dcid_util_time_ns() - beg_ns);
+    p_entry->event = event;
+    p_entry->result = result;
+    p_entry->size = size;
+    p_entry->addr = addr;
+    p_entry->primitive = primitive;
+
+    p_trace->recorded++;
+}
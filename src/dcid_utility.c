@@ -7,112 +7,95 @@
  */
 
 #include "dcid_utility.h"
+#include "dcid_backend.h"
+#include "dcid_cache.h"
 #include "chumby_accel.h" // @note this should be imported at some point!
 
-#include <sys/ioctl.h>
 #include <string.h>
+#include <time.h>
 
-#ifdef CNPLATFORM_avlite
-#include <unistd.h>
-#include <fcntl.h>
-#include <stdio.h>
-#endif
-
-
-#if defined(CNPLATFORM_netv) || defined(CNPLATFORM_wintergrasp)
-#include <unistd.h>
-#include <fcntl.h>
-#include <stdio.h>
-/*************************************************************************/
-#define ESD_CONFIG_AREA_PART1_OFFSET    0xc000
-// pragma pack() not supported on all platforms, so we make everything dword-aligned using arrays
-// WARNING: we're being lazy here and assuming that the platform any utility using this
-// is running on little-endian! Otherwise you'll need to convert u32 values
-typedef union {
-        char name[4];
-        unsigned int uname;
-} block_def_name;
-
-typedef struct _block_def {
-        unsigned int offset;            // Offset from start of partition 1; if 0xffffffff, end of block table
-        unsigned int length;            // Length of block in bytes
-        unsigned char block_ver[4];     // Version of this block data, e.g. 1,0,0,0
-        block_def_name n;               // Name of block, e.g. "krnA" (not NULL-terminated, a-z, A-Z, 0-9 and non-escape symbols allowed)
-} block_def;
-
-typedef struct _config_area {
-        char sig[4];    // 'C','f','g','*'
-        unsigned char area_version[4];  // 1,0,0,0
-        unsigned char active_index[4];  // element 0 is 0 if krnA active, 1 if krnB; elements 1-3 are padding
-        unsigned char updating[4];      // element 0 is 1 if update in progress; elements 1-3 are padding
-        char last_update[16];           // NULL-terminated version of last successful update, e.g. "1.7.1892"
-        unsigned int p1_offset;         // Offset in bytes from start of device to start of partition 1
-        char factory_data[220];         // Data recorded in manufacturing in format KEY=VALUE<newline>...
-        char configname[128];           // NULL-terminated CONFIGNAME of current build, e.g. "silvermoon_sd"
-        unsigned char unused2[128];
-        unsigned char mbr_backup[512];  // Backup copy of MBR
-        block_def block_table[64];      // Block table entries ending with offset==0xffffffff
-        unsigned char unused3[0];
-} config_area;
-
-static int seek_config_block(dcid_t *p_dcid, char *name) {
-    int block;
-    config_area cfg;
-
-    if (p_dcid->device_file == -1) {
-        perror("Unable to open config block device");
-        return 0;
-    }
+uint64_t dcid_util_time_ns()
+{
+    struct timespec now;
 
-    /* Seek to config table */
-    if (-1 == lseek(p_dcid->device_file, ESD_CONFIG_AREA_PART1_OFFSET, SEEK_SET)) {
-        perror("Unable to seek to config area");
-        goto out;
-    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec*1000000000 + now.tv_nsec;
+}
+
+uint64_t dcid_util_time_us()
+{
+    return dcid_util_time_ns() / 1000;
+}
 
-    /* Read config table */
-    if (-1 == read(p_dcid->device_file, &cfg, sizeof(cfg))) {
-        perror("Unable to read config area");
-        goto out;
+void dcid_util_io(dcid_t *p_dcid, int event, int64_t addr, int size, const char *primitive, uint64_t beg_ns, int result)
+{
+    dcid_stats_t *p_stats = &p_dcid->stats;
+
+    switch(event)
+    {
+        case DCID_IO_READ:
+            p_stats->transactions++;
+            p_stats->read_bytes += size;
+            p_dcid->io_pos = addr + size;
+            break;
+
+        case DCID_IO_WRITE:
+            p_stats->transactions++;
+            p_stats->write_bytes += size;
+            p_dcid->io_pos = addr + size;
+            break;
+
+        case DCID_IO_POLL:
+        case DCID_IO_SYNC:
+        case DCID_IO_CONTROL:
+            p_stats->transactions++;
+            break;
+
+        case DCID_IO_SLEEP:
+            p_stats->sleeps++;
+            p_stats->sleep_us += size;
+            break;
     }
 
-    /* Locate cpid block */
-    for (block=0; block < sizeof(cfg.block_table) / sizeof(cfg.block_table[0]); block++) {
-        if (!memcmp(cfg.block_table[block].n.name, name, 4)) {
+    if(p_dcid->trace != 0) { dcid_trace_record(p_dcid, event, addr, size, primitive, beg_ns, result); }
+}
+
+void dcid_util_io_seek(dcid_t *p_dcid, int64_t offset)
+{
+    if(offset != p_dcid->io_pos) { p_dcid->stats.seeks++; }
 
-            /* Seek to specified block */
-            if (-1 == lseek(p_dcid->device_file, cfg.block_table[block].offset, SEEK_SET)) {
-                perror("Unable to seek to cpid block");
-                goto out;
-            }
+    p_dcid->io_pos = offset;
+}
 
-            return 1;
-        }
+/*! read a block directly from the device, in transfers no larger than the backend handles */
+static int device_read_block(dcid_t *p_dcid, unsigned int addr, uint8_t *raw_data, int size)
+{
+    const dcid_backend_t *p_backend = p_dcid->backend;
+
+    int max_read = (p_backend->caps.max_read > 0) ? p_backend->caps.max_read : size;
+
+    int ret = DCID_OK;
+
+    uint64_t beg = dcid_util_time_us();
+
+    while(size > 0)
+    {
+        int len = (size < max_read) ? size : max_read;
+
+        ret = p_backend->read_block(p_dcid, addr, raw_data, len);
+
+        if(DCID_FAILED(ret)) { break; }
+
+        addr += len;
+        raw_data += len;
+        size -= len;
     }
 
-out:
-    return 0;
+    p_dcid->stats.read_us += dcid_util_time_us() - beg;
+
+    return ret;
 }
-#endif
-
-
-#ifdef CNPLATFORM_falconwing
-#include <linux/i2c.h>
-#include <linux/i2c-dev.h>
-#include <stdio.h>
-#include <unistd.h>
-#define DCID_EEPROM_ADDR (0xA8)
-#define PAGE_MULTIPLIER 2
-#endif
-
-#ifdef CNPLATFORM_silvermoon
-#include <linux/i2c.h>
-#include <linux/i2c-dev.h>
-#include <stdio.h>
-#include <unistd.h>
-#define DCID_EEPROM_ADDR (0x50)
-#define PAGE_MULTIPLIER 1
-#endif
 
 int dcid_util_write_raw(dcid_t *p_dcid, unsigned int addr, uint8_t *raw_data, int *p_size)
 {
@@ -144,108 +127,190 @@ int dcid_util_read_raw(dcid_t *p_dcid, unsigned int addr, uint8_t *raw_data, int
     /*! sanity check */
     if(p_size == 0) { return DCID_INVALID_PARAM; }
 
-    unsigned int cur_addr = addr;
+    int size = *p_size;
 
-    for(cur_addr = addr; cur_addr < (addr + (*p_size)); cur_addr++)
-    {
-        ret = dcid_util_read_byte(p_dcid, cur_addr, &raw_data[cur_addr - addr]);
+    /*! fail if out of range */
+    if(addr > DCID_MAX_ADDRESS) { *p_size = 0; return DCID_FAIL; }
 
-        if(DCID_FAILED(ret))
+    /*! clamp to the end of the device */
+    if(size > (int)(DCID_MAX_ADDRESS + 1 - addr)) { size = DCID_MAX_ADDRESS + 1 - addr; }
+
+    if(size > 0)
+    {
+        /*! serve from shadow image if we have one, otherwise go to the device */
+        if(p_dcid->image_valid)
         {
-            *p_size = (cur_addr - addr);
-            break;
+            memcpy(raw_data, &p_dcid->image[addr], size);
+        }
+        else
+        {
+            ret = device_read_block(p_dcid, addr, raw_data, size);
+
+            if(DCID_FAILED(ret)) { *p_size = 0; return ret; }
         }
     }
 
-    return ret;
+    /*! report partial read */
+    if(size < *p_size) { *p_size = size; return DCID_FAIL; }
+
+    return DCID_OK;
 }
 
-int dcid_util_write_flush(dcid_t *p_dcid)
+/*! fill shadow image from the device, unless already loaded */
+static int load_image(dcid_t *p_dcid)
+{
+    /*! already loaded */
+    if(p_dcid->image_valid) { return DCID_OK; }
+
+    int ret = device_read_block(p_dcid, 0, p_dcid->image, DCID_MAX_RAW_SIZE);
+
+    if(DCID_FAILED(ret)) { return ret; }
+
+    p_dcid->image_valid = 1;
+
+    /*! tag index is rebuilt on demand */
+    p_dcid->index_valid = 0;
+
+    return DCID_OK;
+}
+
+int dcid_util_load_image(dcid_t *p_dcid)
+{
+    return load_image(p_dcid);
+}
+
+int dcid_util_read_ident(dcid_t *p_dcid, uint8_t *ident)
+{
+    return device_read_block(p_dcid, DCID_REV_LOC, ident, DCID_IDENT_SIZE);
+}
+
+/*! write all dirty cache positions to the device, keeping the shadow image up to date */
+static int device_write_flush(dcid_t *p_dcid)
 {
+    const dcid_backend_t *p_backend = p_dcid->backend;
+    uint8_t run[DCID_MAX_RAW_SIZE];
+    int prepared = 0, ret = DCID_OK;
+    int done = 0, total = 0;
     int v;
 
-#if defined(CNPLATFORM_netv) || defined(CNPLATFORM_wintergrasp)
-    if (!seek_config_block(p_dcid, "dcid"))
-        return DCID_FAIL;
-#endif
+    int write_page = p_backend->caps.write_page;
+
+    if(write_page <= 0 || write_page > DCID_MAX_RAW_SIZE) { write_page = DCID_MAX_RAW_SIZE; }
+
+    /*! drop staged bytes which the device already holds, so only real changes are written.
+     *  if the current contents cannot be read, every staged byte is written instead. */
+    if(DCID_SUCCESS(load_image(p_dcid)))
+    {
+        for(v=0;v<=DCID_MAX_ADDRESS;v++)
+        {
+            /*! skip clean words in one step */
+            if(p_dcid->write_dirty[v>>5] == 0) { v |= 31; continue; }
+
+            if(DCID_DIRTY_TEST(p_dcid, v) && p_dcid->write_cache[v] == p_dcid->image[v]) { DCID_DIRTY_CLEAR(p_dcid, v); }
+        }
+    }
+
+    /*! bytes left to write, for progress reports */
+    for(v=0;v<DCID_DIRTY_WORDS;v++)
+    {
+        uint32_t word;
 
+        for(word=p_dcid->write_dirty[v];word != 0;word &= word-1) { total++; }
+    }
 
     for(v=0;v<=DCID_MAX_ADDRESS;v++)
     {
-        uint16_t cur = p_dcid->write_cache[v];
+        int len, i;
+
+        /*! skip clean words in one step */
+        if(p_dcid->write_dirty[v>>5] == 0) { v |= 31; continue; }
 
         /*! only write if cache is dirty */
-        if(cur > 255) { continue; }
+        if(!DCID_DIRTY_TEST(p_dcid, v)) { continue; }
 
-#if defined(CNPLATFORM_avlite)
-        int ret = 0;
-        if(-1 == lseek(p_dcid->device_file, v, SEEK_SET)) {
-            perror("Unable to seek");
-            return DCID_FAIL;
-        }
-        if(-1 == write(p_dcid->device_file, (uint8_t *)&cur, sizeof(uint8_t))) {
-            perror("Unable to write");
-            return DCID_FAIL;
+        /*! gather dirty bytes up to the backend write page boundary. clean gaps cost nothing
+         *  extra within one write, so they are filled from the shadow image when we have it */
+        for(len=0;(v+len)<=DCID_MAX_ADDRESS;len++)
+        {
+            if(len > 0 && ((v+len) % write_page) == 0) { break; }
+
+            if(DCID_DIRTY_TEST(p_dcid, v+len)) { run[len] = p_dcid->write_cache[v+len]; }
+            else if(p_dcid->image_valid) { run[len] = p_dcid->image[v+len]; }
+            else { break; }
         }
-#endif // defined(CNPLATFORM_avlite)
 
+        /*! trim clean bytes off the end of the run */
+        while(len > 1 && !DCID_DIRTY_TEST(p_dcid, v+len-1)) { len--; }
+
+        /*! a background flush may be asked to stop between writes */
+        if(dcid_flush_report(p_dcid, done, total)) { ret = DCID_CANCELLED; break; }
 
-#if defined(CNPLATFORM_netv) || defined(CNPLATFORM_wintergrasp)
-        int ret = 0;
-        if(-1 == write(p_dcid->device_file, (uint8_t *)&cur, sizeof(uint8_t))) {
-            perror("Unable to write");
-            return DCID_FAIL;
+        /*! make the device writable once, ahead of the first write */
+        if(!prepared && p_backend->prepare != 0)
+        {
+            ret = p_backend->prepare(p_dcid);
+
+            if(DCID_FAILED(ret)) { return ret; }
         }
-#endif
-
-#if defined(CNPLATFORM_falconwing) || defined(CNPLATFORM_silvermoon)
-        unsigned char output[2];
-        struct i2c_rdwr_ioctl_data packets;
-        struct i2c_msg messages[1];
-        int byte;
-        int page;
-
-        // On this chip, the upper two bits of the memory address are
-        // represented in the i2c address, and the lower eight are clocked in
-        // as the memory address.  This gives a crude mechanism for 4 pages of
-        // 256 bytes each.
-        byte = (v   ) & 0xff;
-        page = (v>>8) & 0x03;
-
-        output[0] = byte;
-        output[1] = (uint8_t)cur;
-
-        messages[0].addr    = DCID_EEPROM_ADDR + (page*PAGE_MULTIPLIER);
-        messages[0].flags   = 0;
-        messages[0].len     = sizeof(output);
-        messages[0].buf     = output;
-
-        packets.msgs    = messages;
-        packets.nmsgs   = 1;
-        if(ioctl(p_dcid->device_file, I2C_RDWR, &packets) < 0) {
-			char error[128];
-			snprintf(error, sizeof(error), "Unable to send v %d on page %d, byte %d\n", v, page, byte);
-            perror(error);
-            return DCID_FAIL;
+
+        prepared = 1;
+
+        ret = p_backend->write_block(p_dcid, v, run, len);
+
+        if(DCID_FAILED(ret)) { break; }
+
+        /*! update shadow image and clear the cache positions covered by this write */
+        for(i=0;i<len;i++)
+        {
+            if(DCID_DIRTY_TEST(p_dcid, v+i)) { done++; }
+
+            p_dcid->image[v+i] = run[i];
+            DCID_DIRTY_CLEAR(p_dcid, v+i);
         }
-        usleep(3*1000);
-        
-        int ret = 0;
-#endif
 
+        v += len-1;
+    }
 
-#if defined(CNPLATFORM_ironforge)
-        struct eeprom_data ed = { .address = v, .data = (uint8_t)cur };
-        int ret = ioctl(p_dcid->device_file, ACCEL_IOCTL_SETROM, &ed);
-#endif
+    dcid_flush_report(p_dcid, done, total);
 
-        if(ret != 0) { return DCID_FAIL; }
+    /*! commit, for backends which buffer writes. this also undoes prepare, so it follows a failed write too */
+    if(p_backend->flush != 0)
+    {
+        int flush_ret = p_backend->flush(p_dcid);
 
-        /*! clear this cache position */
-        p_dcid->write_cache[v] = -1;
+        if(DCID_SUCCESS(ret)) { ret = flush_ret; }
     }
 
-    return DCID_OK;
+    return ret;
+}
+
+int dcid_util_write_flush(dcid_t *p_dcid)
+{
+    uint32_t dirty = 0;
+    int v;
+
+    uint64_t beg = dcid_util_time_us();
+
+    for(v=0;v<DCID_DIRTY_WORDS;v++) { dirty |= p_dcid->write_dirty[v]; }
+
+    int ret = device_write_flush(p_dcid);
+
+    /*! anything staged may have reached the card, so its on-disk cache no longer applies */
+    if(dirty != 0 && p_dcid->cache_dir != 0) { dcid_cache_invalidate(p_dcid); }
+
+    /*! image contents may have changed, so the tag index is rebuilt on demand */
+    p_dcid->index_valid = 0;
+
+    /*! device contents are uncertain after a failed write, so drop the shadow image. a
+     *  cancelled flush stopped between writes, so the shadow image still holds */
+    if(DCID_FAILED(ret) && ret != DCID_CANCELLED) { p_dcid->image_valid = 0; }
+
+    /*! republish, so shared memory readers see the new contents */
+    if(dirty != 0 && p_dcid->shm != 0) { dcid_shm_update(p_dcid); }
+
+    p_dcid->stats.flush_us += dcid_util_time_us() - beg;
+
+    return ret;
 }
 
 int dcid_util_write_byte(dcid_t *p_dcid, unsigned int addr, uint8_t byte_val)
@@ -255,86 +320,33 @@ int dcid_util_write_byte(dcid_t *p_dcid, unsigned int addr, uint8_t byte_val)
 
     /*! update write cache */
     p_dcid->write_cache[addr] = byte_val;
+    DCID_DIRTY_SET(p_dcid, addr);
 
     return DCID_OK;
 }
 
 int dcid_util_read_byte(dcid_t *p_dcid, unsigned int addr, uint8_t *p_byte_ret)
 {
-    struct eeprom_data ed = { .address = addr, .data = 0 };
-
     /*! fail if out of range */
-    if(ed.address > DCID_MAX_ADDRESS) { return DCID_FAIL; }
-    
-#if defined(CNPLATFORM_avlite)
-    int ret = 0;
-    if(-1 == lseek(p_dcid->device_file, addr, SEEK_SET)) {
-        perror("Unable to seek");
-        return DCID_FAIL;
-    }
-    if(-1 == read(p_dcid->device_file, &ed.data, sizeof(uint8_t))) {
-        perror("Unable to read");
-        return DCID_FAIL;
-    }
-#endif // defined(CNPLATFORM_avlite)
-
-#if defined(CNPLATFORM_netv) || defined(CNPLATFORM_wintergrasp)
-    int ret = 0;
-    if (!seek_config_block(p_dcid, "dcid"))
-        return DCID_FAIL;
-    if (-1 == lseek(p_dcid->device_file, ed.address, SEEK_CUR)) {
-        perror("Unable to seek");
-        return DCID_FAIL;
-    }
-    if (-1 == read(p_dcid->device_file, &ed.data, sizeof(uint8_t))) {
-        perror("Unable to read");
-        return DCID_FAIL;
-    }
-#endif
-
-#if defined(CNPLATFORM_falconwing) || defined(CNPLATFORM_silvermoon)
-    int byte = 0;
-    int page = 0;
-    unsigned char output, input;
-    struct i2c_rdwr_ioctl_data packets;
-    struct i2c_msg messages[2];
-
-    // On this chip, the upper two bits of the memory address are
-    // represented in the i2c address, and the lower eight are clocked in
-    // as the memory address.  This gives a crude mechanism for 4 pages of
-    // 256 bytes each.
-    byte = (addr   ) & 0xff;
-    page = (addr>>8) & 0x03;
-
-    output = byte;
-    messages[0].addr    = DCID_EEPROM_ADDR + (page*PAGE_MULTIPLIER);
-    messages[0].flags   = 0;
-    messages[0].len     = sizeof(output);
-    messages[0].buf     = &output;
-
-    messages[1].addr    = DCID_EEPROM_ADDR + (page*PAGE_MULTIPLIER);
-    messages[1].flags   = I2C_M_RD;
-    messages[1].len     = sizeof(input);
-    messages[1].buf     = &input;
-
-    packets.msgs    = messages;
-    packets.nmsgs   = 2;
-    if(ioctl(p_dcid->device_file, I2C_RDWR, &packets) < 0) {
-        perror("Failure");
-        return DCID_FAIL;
+    if(addr > DCID_MAX_ADDRESS) { return DCID_FAIL; }
+
+    /*! serve from shadow image if we have one */
+    if(p_dcid->image_valid)
+    {
+        if(p_byte_ret != 0) { *p_byte_ret = p_dcid->image[addr]; }
+
+        return DCID_OK;
     }
-    
-    ed.data = input;
-    int ret = 0;
-#endif
 
-#if defined(CNPLATFORM_ironforge)
-    int ret = ioctl(p_dcid->device_file, ACCEL_IOCTL_READROM, &ed);
-#endif
+    {
+        uint8_t byte_val = 0;
+
+        int ret = device_read_block(p_dcid, addr, &byte_val, 1);
 
-    if(ret != 0) { return DCID_FAIL; }
+        if(DCID_FAILED(ret)) { return ret; }
 
-    if(p_byte_ret != 0) { *p_byte_ret = ed.data; }
+        if(p_byte_ret != 0) { *p_byte_ret = byte_val; }
+    }
 
     return DCID_OK;
 }
@@ -352,17 +364,15 @@ int dcid_util_write_uint16(dcid_t *p_dcid, unsigned int addr, uint16_t uint16_va
 
 int dcid_util_read_uint16(dcid_t *p_dcid, unsigned int addr, uint16_t *p_uint16_ret)
 {
-    uint8_t byte_l, byte_h;
+    uint8_t bytes[2];
 
-    int ret = dcid_util_read_byte(p_dcid, addr, &byte_h);
+    int size = 2;
 
-    if(DCID_FAILED(ret)) { return ret; }
-
-    ret = dcid_util_read_byte(p_dcid, addr+1, &byte_l);
+    int ret = dcid_util_read_raw(p_dcid, addr, bytes, &size);
 
     if(DCID_FAILED(ret)) { return ret; }
-    
-    *p_uint16_ret = (byte_h << 8) | byte_l;
+
+    *p_uint16_ret = (bytes[0] << 8) | bytes[1];
 
     return DCID_OK;
 }
@@ -16,6 +16,16 @@ extern "C" {
 #endif
 
 #include "dcid_interface.h"
+#include "dcid_backend.h"
+#include "dcid_trace.h"
+
+/*! \name write cache dirty bitmap helpers */
+/*! \{ */
+#define DCID_DIRTY_WORDS                ((DCID_MAX_RAW_SIZE+31)/32)
+#define DCID_DIRTY_TEST(p_dcid, addr)   ((p_dcid)->write_dirty[(addr)>>5] &   (1u << ((addr)&31)))
+#define DCID_DIRTY_SET(p_dcid, addr)    ((p_dcid)->write_dirty[(addr)>>5] |=  (1u << ((addr)&31)))
+#define DCID_DIRTY_CLEAR(p_dcid, addr)  ((p_dcid)->write_dirty[(addr)>>5] &= ~(1u << ((addr)&31)))
+/*! \} */
 
 /*! write raw bytes to dcid device */
 int dcid_util_write_raw(dcid_t *p_dcid, unsigned int addr, uint8_t *raw_data, int *p_size);
@@ -35,9 +45,53 @@ int dcid_util_write_uint16(dcid_t *p_dcid, unsigned int addr, uint16_t uint16_va
 /*! read a single uint16 from dcid device */
 int dcid_util_read_uint16(dcid_t *p_dcid, unsigned int addr, uint16_t *p_uint16_ret);
 
+/*! fill shadow image from dcid device, unless already loaded */
+int dcid_util_load_image(dcid_t *p_dcid);
+
+/*! size of the card identity (revision and serial number), in bytes */
+#define DCID_IDENT_SIZE 16
+
+/*! read card identity, which sits just past the image and is not covered by the write cache */
+int dcid_util_read_ident(dcid_t *p_dcid, uint8_t *ident);
+
+/*! refresh the shared memory snapshot published by this instance (see dcid_shm.h) */
+int dcid_shm_update(dcid_t *p_dcid);
+
+/*! open path read/write as the device file, for backends with nothing special to do */
+int dcid_backend_open_device(dcid_t *p_dcid, const char *path);
+
+/*! close the device file, for backends with nothing special to do */
+int dcid_backend_close_device(dcid_t *p_dcid);
+
+/*! start time of a device operation, for dcid_util_io. only taken while tracing */
+#define DCID_IO_BEGIN(p_dcid) (((p_dcid)->trace != 0) ? dcid_util_time_ns() : 0)
+
+/*! account for one completed device operation (DCID_IO_ event, see dcid_trace.h). backends
+ *  call this for everything they ask of the device, with beg_ns from DCID_IO_BEGIN */
+void dcid_util_io(dcid_t *p_dcid, int event, int64_t addr, int size, const char *primitive, uint64_t beg_ns, int result);
+
+/*! account for a block device access at offset, which is a seek unless it follows on from the last one */
+void dcid_util_io_seek(dcid_t *p_dcid, int64_t offset);
+
+/*! record one device operation in the trace ring (see dcid_trace.h) */
+void dcid_trace_record(dcid_t *p_dcid, int event, int64_t addr, int size, const char *primitive, uint64_t beg_ns, int result);
+
+/*! current monotonic time, in nanoseconds */
+uint64_t dcid_util_time_ns();
+
+/*! current monotonic time, in microseconds */
+uint64_t dcid_util_time_us();
+
 /*! flush write cache to device */
 int dcid_util_write_flush(dcid_t *p_dcid);
 
+/*! report progress of a flush, in bytes. returns non-zero if a background flush has been
+ *  asked to stop, in which case no more writes should be issued */
+int dcid_flush_report(dcid_t *p_dcid, int done, int total);
+
+/*! release background flush state, waiting for the worker if it is still running */
+void dcid_flush_destroy(dcid_t *p_dcid);
+
 #ifdef __cplusplus
 }
 #endif
@@ -9,10 +9,14 @@
  */
 
 #include "dcid_interface.h"
+#include "dcid_daemon.h"
+#include "dcid_shm.h"
+#include "dcid_trace.h"
 
 #include <stdio.h>
 #include <malloc.h>
 #include <memory.h>
+#include <string.h>
 
 /*! serial port device path */
 #if defined(CNPLATFORM_falconwing) || defined(CNPLATFORM_silvermoon)
@@ -35,9 +39,16 @@
 #define DCID_DEVICE_PATH "/dev/mmcblk0p2"
 #endif
 
+#if defined(CNPLATFORM_sim)
+#define DCID_DEVICE_PATH "dcid-sim.bin"
+#endif
+
 /*! print program usage screen */
 static void show_usage();
 
+/*! print performance counters of an instance */
+static void show_stats(dcid_t *p_dcid);
+
 int main(int argc, char **argv)
 {
     /*! default at failure */
@@ -49,6 +60,30 @@ int main(int argc, char **argv)
     /*! output file, if specified */
     FILE *out_file = 0;
 
+    /*! record path to look up, if specified */
+    char *query_path = 0;
+
+    /*! on-disk cache directory, if specified */
+    char *cache_dir = 0;
+
+    /*! serve requests over a socket, rather than run once */
+    int run_daemon = 0;
+
+    /*! publish image to shared memory */
+    int publish_shm = 0;
+
+    /*! print performance counters once done */
+    int print_stats = 0;
+
+    /*! trace device operations, and print them once done */
+    int print_trace = 0;
+
+    /*! server socket path, 0 for the default */
+    char *socket_path = 0;
+
+    /*! connection to a running server, if there is one */
+    int daemon_fd = -1;
+
     /*! temporary buffer */
     char *tmp_buffer = (char*)malloc(DCID_MAX_XML_SIZE);
 
@@ -123,9 +158,55 @@ int main(int argc, char **argv)
                 }
                 break;
 
+                case 'q':
+                {
+                    /*! skip over to record path */
+                    if(++cur_arg >= argc) { break; }
+
+                    query_path = argv[cur_arg];
+                }
+                break;
+
+                case 'c':
+                {
+                    /*! skip over to cache directory */
+                    if(++cur_arg >= argc) { break; }
+
+                    cache_dir = argv[cur_arg];
+                }
+                break;
+
                 case '-':
-                    print_usage = 1;
-                    break;
+                {
+                    if(strcmp(argv[cur_arg], "--daemon") == 0)
+                    {
+                        run_daemon = 1;
+                    }
+                    else if(strcmp(argv[cur_arg], "--shm") == 0)
+                    {
+                        publish_shm = 1;
+                    }
+                    else if(strcmp(argv[cur_arg], "--stats") == 0)
+                    {
+                        print_stats = 1;
+                    }
+                    else if(strcmp(argv[cur_arg], "--trace") == 0)
+                    {
+                        print_trace = 1;
+                    }
+                    else if(strcmp(argv[cur_arg], "--socket") == 0)
+                    {
+                        /*! skip over to socket path */
+                        if(++cur_arg >= argc) { break; }
+
+                        socket_path = argv[cur_arg];
+                    }
+                    else
+                    {
+                        print_usage = 1;
+                    }
+                }
+                break;
 
                 default:
                 {
@@ -143,10 +224,30 @@ int main(int argc, char **argv)
         goto cleanup;
     }
 
+    /*! let a running server answer, rather than scan the device again */
+    if(!run_daemon && DCID_SUCCESS(dcid_client_open(socket_path, &daemon_fd)))
+    {
+        if(!print_stats && !print_trace && !publish_shm && cache_dir == 0) { goto requests; }
+
+        /*! counters, traces, the shared memory snapshot and the on-disk cache all belong to our
+         *  own instance, so -c, --shm, --stats and --trace go to the device. a write there would
+         *  go behind the server's back, leaving it serving the old contents, so that is refused */
+        dcid_client_close(daemon_fd);
+        daemon_fd = -1;
+
+        if(inp_file != 0)
+        {
+            fprintf(stderr, "Error: a dcid server is running, so -w and -i cannot be combined with -c, --shm, --stats or --trace\n");
+            goto cleanup;
+        }
+    }
+
     /*! create DCID instance */
     {
         dcid_info_t dcid_info = { 0 };
 
+        dcid_info.cache_dir = cache_dir;
+
         int ret = dcid_create(&dcid_info, &p_dcid);
 
         if(DCID_FAILED(ret)) 
@@ -156,6 +257,18 @@ int main(int argc, char **argv)
         }
     }
 
+    /*! optionally trace device operations, from initialization on */
+    if(print_trace)
+    {
+        int ret = dcid_trace_enable(p_dcid, DCID_TRACE_DEFAULT_ENTRIES);
+
+        if(DCID_FAILED(ret))
+        {
+            fprintf(stderr, "Error: dcid_trace_enable failed (%s)\n", DCID_RETURN_CODE_LOOKUP[ret]);
+            goto cleanup;
+        }
+    }
+
     /*! initialize DCID instance */
     {
         int ret = dcid_init(p_dcid, DCID_DEVICE_PATH);
@@ -167,31 +280,87 @@ int main(int argc, char **argv)
         }
     }
 
+    /*! optionally publish image to shared memory, kept current by any writes below */
+    if(publish_shm)
+    {
+        int ret = dcid_shm_publish(p_dcid, 0);
+
+        if(DCID_FAILED(ret))
+        {
+            fprintf(stderr, "Error: dcid_shm_publish failed (%s)\n", DCID_RETURN_CODE_LOOKUP[ret]);
+            goto cleanup;
+        }
+    }
+
+    /*! optionally become the server for this device */
+    if(run_daemon)
+    {
+        int ret = dcid_daemon_run(p_dcid, socket_path);
+
+        fprintf(stderr, "Error: dcid_daemon_run failed (%s)\n", DCID_RETURN_CODE_LOOKUP[ret]);
+        goto cleanup;
+    }
+
+requests:
+
     /*! optionally write dcid device data */
     if(inp_file != 0)
     {
-        int size = 0;
+        int ret;
 
-        /*! read up to max buffer size minus null terminator */
+        if(daemon_fd != -1)
         {
-            size_t ret = fread(tmp_buffer, 1, DCID_MAX_XML_SIZE-1, inp_file);
+            /*! the daemon takes the document in one request, so it must fit the buffer along with a null terminator */
+            size_t got = fread(tmp_buffer, 1, DCID_MAX_XML_SIZE, inp_file);
+
+            if(ferror(inp_file))
+            {
+                fprintf(stderr, "Error: failed reading input\n");
+                goto cleanup;
+            }
+
+            if(got >= DCID_MAX_XML_SIZE)
+            {
+                fprintf(stderr, "Error: input exceeds %d bytes\n", DCID_MAX_XML_SIZE-1);
+                goto cleanup;
+            }
 
-            /*! update size */
-            if(ret > 0) { size = ret; }
+            int size = (int)got;
 
             /*! append null terminator */
             tmp_buffer[size] = '\0';
-        }
 
-        /*! write input data to device */
+            ret = dcid_client_write_xml(daemon_fd, tmp_buffer, &size);
+        }
+        else
         {
-            int ret = dcid_write_xml(p_dcid, tmp_buffer, &size);
+            /*! stream input through the encoder a buffer at a time, so its size is not limited */
+            ret = dcid_write_begin(p_dcid);
 
-            if(DCID_FAILED(ret))
+            while(DCID_SUCCESS(ret))
             {
-                fprintf(stderr, "Error: dcid_write_xml failed (%s)\n", DCID_RETURN_CODE_LOOKUP[ret]);
-                goto cleanup;
+                size_t got = fread(tmp_buffer, 1, DCID_MAX_XML_SIZE, inp_file);
+
+                if(got == 0) { break; }
+
+                ret = dcid_write_feed(p_dcid, tmp_buffer, (int)got);
             }
+
+            /*! a read error leaves the document short, so it is not written */
+            if(DCID_SUCCESS(ret) && ferror(inp_file))
+            {
+                fprintf(stderr, "Error: failed reading input\n");
+                ret = DCID_FAIL;
+            }
+
+            /*! only write the device if the whole document was encoded */
+            if(DCID_SUCCESS(ret)) { ret = dcid_write_end(p_dcid, 1); } else { dcid_write_end(p_dcid, 0); }
+        }
+
+        if(DCID_FAILED(ret))
+        {
+            fprintf(stderr, "Error: dcid_write_xml failed (%s)\n", DCID_RETURN_CODE_LOOKUP[ret]);
+            goto cleanup;
         }
     }
 
@@ -202,7 +371,7 @@ int main(int argc, char **argv)
 
         /*! read up to max buffer size */
         {
-            int ret = dcid_read_xml(p_dcid, tmp_buffer, &size);
+            int ret = (daemon_fd != -1) ? dcid_client_read_xml(daemon_fd, tmp_buffer, &size) : dcid_read_xml(p_dcid, tmp_buffer, &size);
 
             if(DCID_FAILED(ret))
             {
@@ -218,12 +387,30 @@ int main(int argc, char **argv)
 
             if(ret != size-1) 
             { 
-                fprintf(stderr, "Error: fwrite returned %d, expected %d\n", ret, size-1); 
+                fprintf(stderr, "Error: fwrite returned %d, expected %d\n", (int)ret, size-1); 
                 goto cleanup;
             }
         }
     }
 
+    /*! optionally look up a single record */
+    if(query_path != 0)
+    {
+        int size = DCID_MAX_XML_SIZE, v;
+
+        int ret = (daemon_fd != -1) ? dcid_client_get(daemon_fd, query_path, (uint8_t*)tmp_buffer, &size) : dcid_get(p_dcid, query_path, (uint8_t*)tmp_buffer, &size);
+
+        if(DCID_FAILED(ret))
+        {
+            fprintf(stderr, "Error: dcid_get \"%s\" failed (%s)\n", query_path, DCID_RETURN_CODE_LOOKUP[ret]);
+            goto cleanup;
+        }
+
+        /*! print payload as hex, same as the XML form */
+        for(v=0;v<size;v++) { printf("%.02X", (uint8_t)tmp_buffer[v]); }
+        printf("\n");
+    }
+
     main_ret = 0;
 
 cleanup:
@@ -242,6 +429,13 @@ cleanup:
         out_file = 0;
     }
 
+    /*! cleanup server connection */
+    if(daemon_fd != -1)
+    {
+        dcid_client_close(daemon_fd);
+        daemon_fd = -1;
+    }
+
     /*! cleanup temp buffer */
     if(tmp_buffer != 0)
     {
@@ -252,6 +446,9 @@ cleanup:
     /*! cleanup DCID instance */
     if(p_dcid != 0)
     {
+        if(print_trace) { dcid_trace_dump(p_dcid, stderr); }
+        if(print_stats) { show_stats(p_dcid); }
+
         int ret = dcid_close(p_dcid);
 
         if(DCID_FAILED(ret))
@@ -264,12 +461,31 @@ cleanup:
     return main_ret;
 }
 
+static void show_stats(dcid_t *p_dcid)
+{
+    dcid_stats_t stats;
+
+    if(DCID_FAILED(dcid_get_stats(p_dcid, &stats))) { return; }
+
+    /*! stdout may be carrying card data, so counters go to stderr */
+    fprintf(stderr, "transactions  %u\n", stats.transactions);
+    fprintf(stderr, "read bytes    %u\n", stats.read_bytes);
+    fprintf(stderr, "write bytes   %u\n", stats.write_bytes);
+    fprintf(stderr, "seeks         %u\n", stats.seeks);
+    fprintf(stderr, "sleeps        %u (%llu us)\n", stats.sleeps, (unsigned long long)stats.sleep_us);
+    fprintf(stderr, "read time     %llu us\n", (unsigned long long)stats.read_us);
+    fprintf(stderr, "parse time    %llu us\n", (unsigned long long)stats.parse_us);
+    fprintf(stderr, "encode time   %llu us\n", (unsigned long long)stats.encode_us);
+    fprintf(stderr, "flush time    %llu us\n", (unsigned long long)stats.flush_us);
+}
+
 static void show_usage()
 {
     printf("DCID 1.0 [caustik@chumby.com]\n");
     printf("\n");
 #ifdef DCID_ALLOW_WRITE
-    printf("Usage : dcid [--help] | [-r <FILE>] [-w <FILE>] [-i] [-o]\n");
+    printf("Usage : dcid [--help] | [-r <FILE>] [-w <FILE>] [-i] [-o] [-q <PATH>] [-c <DIR>]\n");
+    printf("        [--daemon] [--socket <PATH>] [--shm] [--stats] [--trace]\n");
     printf("\n");
     printf("Read/Write from DCID device\n");
     printf("\n");
@@ -281,8 +497,17 @@ static void show_usage()
     printf("    -r <FILE>   Write contents of \"%s\" to FILE\n", DCID_DEVICE_PATH);
     printf("    -i          Write contents of stdin to \"%s\" (ignored if valid -w specified)\n", DCID_DEVICE_PATH);
     printf("    -o          Write contents of \"%s\" to stdout (ignored if valid -r specified)\n", DCID_DEVICE_PATH);
+    printf("    -q <PATH>   Write payload of record PATH (e.g. \"nod1/nod3/nod4\") to stdout as hex\n");
+    printf("    -c <DIR>    Keep decoded card data in DIR, keyed by card serial number\n");
+    printf("    --daemon    Stay resident and answer requests from other dcid processes\n");
+    printf("    --socket <PATH>  Server socket (default \"%s\")\n", DCID_DAEMON_SOCKET_PATH);
+    printf("    --shm       Publish card image to \"%s\" for shared memory readers\n", DCID_SHM_PATH);
+    printf("    --stats     Print device and timing counters to stderr when done\n");
+    printf("    --trace     Print the last %d device operations to stderr when done\n", DCID_TRACE_DEFAULT_ENTRIES);
+    printf("                -c, --shm, --stats and --trace bypass a running server, so they cannot be\n");
+    printf("                combined with -w or -i while one is running\n");
 #else
-    printf("Usage : dcid [-r FILE] [-o]\n");
+    printf("Usage : dcid [-r FILE] [-o] [-q PATH] [-c DIR] [--daemon] [--socket PATH] [--shm] [--stats] [--trace]\n");
     printf("\n");
     printf("Read from DCID device\n");
     printf("\n");
@@ -291,6 +516,13 @@ static void show_usage()
     printf("Options:\n");
     printf("    -r <FILE>   Write contents of \"%s\" to FILE\n", DCID_DEVICE_PATH);
     printf("    -o          Write contents of \"%s\" to stdout\n", DCID_DEVICE_PATH);
+    printf("    -q <PATH>   Write payload of record PATH (e.g. \"nod1/nod3/nod4\") to stdout as hex\n");
+    printf("    -c <DIR>    Keep decoded card data in DIR, keyed by card serial number\n");
+    printf("    --daemon    Stay resident and answer requests from other dcid processes\n");
+    printf("    --socket <PATH>  Server socket (default \"%s\")\n", DCID_DAEMON_SOCKET_PATH);
+    printf("    --shm       Publish card image to \"%s\" for shared memory readers\n", DCID_SHM_PATH);
+    printf("    --stats     Print device and timing counters to stderr when done\n");
+    printf("    --trace     Print the last %d device operations to stderr when done\n", DCID_TRACE_DEFAULT_ENTRIES);
 #endif
     printf("\n");
     return;
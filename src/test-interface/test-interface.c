@@ -9,18 +9,107 @@
  */
 
 #include "dcid_interface.h"
+#include "dcid_shm.h"
+#include "dcid_trace.h"
+#include "dcid_backend.h"
+#include "dcid_accel.h"
+#include "dcid_daemon.h"
+#include "chumby_accel.h"
+
+#if defined(CNPLATFORM_sim)
+#include "dcid_sim.h"
+#endif
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <malloc.h>
 #include <memory.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
 
 /*! serial port device path */
 #if defined(CNPLATFORM_falconwing) || defined(CNPLATFORM_silvermoon)
 #define DCID_DEVICE_PATH "/dev/i2c-0"
+#elif defined(CNPLATFORM_sim)
+#define DCID_DEVICE_PATH "dcid-sim.bin"
 #else
 #define DCID_DEVICE_PATH "/dev/dcid"
 #endif
 
+/*! stub chumby_accel driver, holding the rom in memory */
+static struct
+{
+    int bulk;               /*!< non-zero to accept the bulk commands */
+    int locked;             /*!< rom write protection */
+    int unlocks;            /*!< UNLOCKROM requests */
+    int bulk_requests;      /*!< bulk requests accepted */
+    int byte_requests;      /*!< per byte requests accepted */
+    int locked_writes;      /*!< writes refused for write protection */
+    uint8_t rom[0x400];
+}
+stub_accel;
+
+static int stub_accel_ioctl(int fd, unsigned long request, void *arg)
+{
+    struct eeprom_bulk_data *p_bd = (struct eeprom_bulk_data*)arg;
+    struct eeprom_data *p_ed = (struct eeprom_data*)arg;
+
+    if(request == ACCEL_IOCTL_UNLOCKROM) { stub_accel.locked = 0; stub_accel.unlocks++; return 0; }
+    if(request == ACCEL_IOCTL_LOCKROM) { stub_accel.locked = 1; return 0; }
+
+    if(request == ACCEL_IOCTL_READROM_BULK || request == ACCEL_IOCTL_SETROM_BULK)
+    {
+        if(!stub_accel.bulk) { errno = ENOTTY; return -1; }
+        if(p_bd->address + p_bd->length > sizeof(stub_accel.rom)) { errno = EFAULT; return -1; }
+
+        if(request == ACCEL_IOCTL_READROM_BULK) { memcpy(p_bd->data, &stub_accel.rom[p_bd->address], p_bd->length); }
+        else if(stub_accel.locked) { stub_accel.locked_writes++; errno = EACCES; return -1; }
+        else { memcpy(&stub_accel.rom[p_bd->address], p_bd->data, p_bd->length); }
+
+        stub_accel.bulk_requests++;
+        return 0;
+    }
+
+    if(request == ACCEL_IOCTL_READROM || request == ACCEL_IOCTL_SETROM)
+    {
+        if(p_ed->address >= sizeof(stub_accel.rom)) { errno = EFAULT; return -1; }
+
+        if(request == ACCEL_IOCTL_READROM) { p_ed->data = stub_accel.rom[p_ed->address]; }
+        else if(stub_accel.locked) { stub_accel.locked_writes++; errno = EACCES; return -1; }
+        else { stub_accel.rom[p_ed->address] = p_ed->data; }
+
+        stub_accel.byte_requests++;
+        return 0;
+    }
+
+    errno = ENOTTY;
+    return -1;
+}
+
+/*! background flush completion, as seen by the callback */
+static int flush_calls = 0, flush_result = DCID_FAIL;
+
+static void flush_done(dcid_t *p_dcid, int result, void *p_context)
+{
+    flush_calls++;
+    flush_result = result;
+}
+
+/*! plain file writes, which ask any background flush to stop once its first write is under way */
+static int cancel_write_block(dcid_t *p_dcid, unsigned int addr, const uint8_t *data, int size)
+{
+    dcid_flush_cancel(p_dcid);
+
+    return dcid_backend_file.write_block(p_dcid, addr, data, size);
+}
+
 int main(int argc, char **argv)
 {
     /*! default at failure */
@@ -75,7 +164,7 @@ int main(int argc, char **argv)
             goto cleanup;
         }
 
-        size = strlen(tmp_buffer)+1;
+        size = DCID_MAX_XML_SIZE;
 
         /*! clear out old XML, to get fresh results */
         memset(tmp_buffer, 0, size);
@@ -93,8 +182,1299 @@ int main(int argc, char **argv)
             fprintf(stderr, "Error: dcid_read_xml gave the wrong XML, expected:\n%s\ngot:\n%s\n", test_xml_out, tmp_buffer);
             goto cleanup;
         }
+
+        if(size != strlen(test_xml_out)+1)
+        {
+            fprintf(stderr, "Error: dcid_read_xml reported size %d, expected %d\n", size, (int)strlen(test_xml_out)+1);
+            goto cleanup;
+        }
+
+        /*! one byte short of the rendered XML must be refused, without overrunning */
+        size = strlen(test_xml_out);
+
+        memset(tmp_buffer, 'x', DCID_MAX_XML_SIZE);
+
+        ret = dcid_read_xml(p_dcid, tmp_buffer, &size);
+
+        if(ret != DCID_BUFFER_TOO_SMALL || tmp_buffer[size] != 'x')
+        {
+            fprintf(stderr, "Error: dcid_read_xml did not respect buffer size (ret := %d)\n", ret);
+            goto cleanup;
+        }
+    }
+
+    printf("Testing raw image...\n");
+
+    /*! test raw image matches the XML written above */
+    {
+        uint8_t raw[DCID_MAX_RAW_SIZE];
+
+        static const uint8_t hdr[10] = { 's', 'e', 'x', 'i', 0x00, 0xB2, 'n', 'o', 'd', '1' };
+
+        int size = sizeof(raw);
+
+        int ret = dcid_read_image(p_dcid, raw, &size);
+
+        if(DCID_FAILED(ret) || size != DCID_MAX_RAW_SIZE)
+        {
+            fprintf(stderr, "Error: dcid_read_image failed (ret := %d, size := %d)\n", ret, size);
+            goto cleanup;
+        }
+
+        if(memcmp(raw, hdr, sizeof(hdr)) != 0)
+        {
+            fprintf(stderr, "Error: dcid_read_image gave the wrong header\n");
+            goto cleanup;
+        }
+    }
+
+    printf("Testing in-memory codec...\n");
+
+    /*! decoding the card image must match dcid_read_xml, and encoding that XML must give the image back */
+    {
+        uint8_t raw[DCID_MAX_RAW_SIZE], enc[DCID_MAX_RAW_SIZE];
+
+        char *xml = (char*)malloc(DCID_MAX_XML_SIZE);
+
+        int raw_size = sizeof(raw), enc_size = sizeof(enc), size = DCID_MAX_XML_SIZE, xml_size = DCID_MAX_XML_SIZE;
+
+        int ret = dcid_read_image(p_dcid, raw, &raw_size);
+
+        if(DCID_SUCCESS(ret)) { ret = dcid_read_xml(p_dcid, tmp_buffer, &size); }
+        if(DCID_SUCCESS(ret)) { ret = dcid_decode_image(raw, raw_size, xml, &xml_size); }
+        if(DCID_SUCCESS(ret)) { ret = dcid_encode_xml(xml, enc, &enc_size); }
+
+        if(DCID_FAILED(ret) || xml_size != size || strcmp(xml, tmp_buffer) != 0 || memcmp(enc, raw, enc_size) != 0)
+        {
+            fprintf(stderr, "Error: in-memory codec does not match the device (ret := %d)\n", ret);
+            free(xml);
+            goto cleanup;
+        }
+
+        /*! too small an image buffer reports the required size */
+        raw_size = 4;
+
+        ret = dcid_encode_xml(xml, raw, &raw_size);
+
+        free(xml);
+
+        if(ret != DCID_BUFFER_TOO_SMALL || raw_size != enc_size)
+        {
+            fprintf(stderr, "Error: dcid_encode_xml did not respect buffer size (ret := %d, size := %d)\n", ret, raw_size);
+            goto cleanup;
+        }
+    }
+
+    printf("Testing performance counters...\n");
+
+    /*! a fresh instance reads the image once, and writes nothing for a read */
+    {
+        dcid_info_t dcid_info = { 0 };
+
+        dcid_t *p_dcid_fresh = 0;
+
+        dcid_stats_t stats = { 0 };
+
+        int size = DCID_MAX_XML_SIZE;
+
+        int ret = dcid_create(&dcid_info, &p_dcid_fresh);
+
+        if(DCID_SUCCESS(ret)) { ret = dcid_init(p_dcid_fresh, DCID_DEVICE_PATH); }
+        if(DCID_SUCCESS(ret)) { ret = dcid_read_xml(p_dcid_fresh, tmp_buffer, &size); }
+        if(DCID_SUCCESS(ret)) { ret = dcid_get_stats(p_dcid_fresh, &stats); }
+
+        if(DCID_FAILED(ret) || stats.transactions == 0 || stats.read_bytes < DCID_MAX_RAW_SIZE || stats.write_bytes != 0)
+        {
+            fprintf(stderr, "Error: unexpected counters (ret := %d, transactions := %u, read := %u, written := %u)\n", ret, stats.transactions, stats.read_bytes, stats.write_bytes);
+            if(p_dcid_fresh != 0) { dcid_close(p_dcid_fresh); }
+            goto cleanup;
+        }
+
+        if(DCID_SUCCESS(ret)) { ret = dcid_reset_stats(p_dcid_fresh); }
+        if(DCID_SUCCESS(ret)) { ret = dcid_get_stats(p_dcid_fresh, &stats); }
+
+        if(p_dcid_fresh != 0) { dcid_close(p_dcid_fresh); }
+
+        if(DCID_FAILED(ret) || stats.transactions != 0 || stats.read_bytes != 0 || stats.read_us != 0)
+        {
+            fprintf(stderr, "Error: counters not reset (ret := %d)\n", ret);
+            goto cleanup;
+        }
+    }
+
+    printf("Testing device trace...\n");
+
+    /*! a fresh instance reading the image records it, and a small ring keeps only the newest entries */
+    {
+        dcid_info_t dcid_info = { 0 };
+
+        dcid_t *p_dcid_fresh = 0;
+
+        dcid_trace_entry_t entries[4];
+
+        int size = DCID_MAX_XML_SIZE, count = 4;
+
+        int ret = dcid_create(&dcid_info, &p_dcid_fresh);
+
+        if(DCID_SUCCESS(ret)) { ret = dcid_trace_enable(p_dcid_fresh, 2); }
+        if(DCID_SUCCESS(ret)) { ret = dcid_init(p_dcid_fresh, DCID_DEVICE_PATH); }
+        if(DCID_SUCCESS(ret)) { ret = dcid_read_xml(p_dcid_fresh, tmp_buffer, &size); }
+        if(DCID_SUCCESS(ret)) { ret = dcid_trace_read(p_dcid_fresh, entries, &count); }
+
+        if(DCID_FAILED(ret) || count < 1 || count > 2 || entries[count-1].event != DCID_IO_READ || entries[count-1].result != DCID_OK || entries[count-1].size <= 0)
+        {
+            fprintf(stderr, "Error: unexpected trace (ret := %d, count := %d)\n", ret, count);
+            if(p_dcid_fresh != 0) { dcid_close(p_dcid_fresh); }
+            goto cleanup;
+        }
+
+        /*! disabled tracing has nothing to read */
+        if(DCID_SUCCESS(ret)) { ret = dcid_trace_enable(p_dcid_fresh, 0); }
+        if(DCID_SUCCESS(ret)) { ret = dcid_trace_read(p_dcid_fresh, entries, &count); }
+
+        if(p_dcid_fresh != 0) { dcid_close(p_dcid_fresh); }
+
+        if(ret != DCID_INVALID_CALL)
+        {
+            fprintf(stderr, "Error: dcid_trace_read succeeded with tracing disabled (ret := %d)\n", ret);
+            goto cleanup;
+        }
+    }
+
+    printf("Testing mapped image file...\n");
+
+    /*! XML written through the mmap backend reads back the same through the file backend */
+    {
+        static const char *map_path = "/tmp/dcid-test-mmap.bin";
+
+        dcid_info_t dcid_info = { 0 };
+
+        dcid_t *p_dcid_map = 0;
+
+        char *xml = (char*)malloc(DCID_MAX_XML_SIZE);
+
+        int size = DCID_MAX_XML_SIZE, xml_size = DCID_MAX_XML_SIZE;
+
+        unlink(map_path);
+
+        /*! use the card contents written above */
+        int ret = dcid_read_xml(p_dcid, xml, &xml_size);
+
+        dcid_info.backend = dcid_backend_find("mmap");
+
+        if(DCID_SUCCESS(ret)) { ret = dcid_create(&dcid_info, &p_dcid_map); }
+        if(DCID_SUCCESS(ret)) { ret = dcid_init(p_dcid_map, (char*)map_path); }
+        if(DCID_SUCCESS(ret)) { ret = dcid_write_xml(p_dcid_map, xml, &xml_size); }
+
+        if(p_dcid_map != 0) { dcid_close(p_dcid_map); p_dcid_map = 0; }
+
+        dcid_info.backend = dcid_backend_find("file");
+
+        if(DCID_SUCCESS(ret)) { ret = dcid_create(&dcid_info, &p_dcid_map); }
+        if(DCID_SUCCESS(ret)) { ret = dcid_init(p_dcid_map, (char*)map_path); }
+        if(DCID_SUCCESS(ret)) { ret = dcid_read_xml(p_dcid_map, tmp_buffer, &size); }
+
+        if(p_dcid_map != 0) { dcid_close(p_dcid_map); }
+
+        unlink(map_path);
+
+        if(DCID_FAILED(ret) || strcmp(xml, tmp_buffer) != 0)
+        {
+            fprintf(stderr, "Error: mapped image file round trip failed (ret := %d)\n", ret);
+            free(xml);
+            goto cleanup;
+        }
+
+        free(xml);
+    }
+
+    printf("Testing eMMC read-modify-write...\n");
+
+    /*! against a file holding a config area, each flavour writes the dcid block back as one
+     *  sector aligned pwrite, syncs unless told not to, leaves the rest of the covering
+     *  sectors alone, and reads back the same */
+    {
+        static const char *emmc_names[3] = { "emmc", "emmc-direct", "emmc-nosync" };
+
+        static const char *emmc_path = "/tmp/dcid-test-emmc.bin";
+
+        /*! config area location, offset of its block table, and a dcid block which does not
+         *  start on a sector boundary */
+        const int cfg_offset = 0xC000, table_offset = 1024, block_offset = 0x10000 + 100;
+
+        /*! sectors covering the block, as the backend assumes for a regular file */
+        const int sector_beg = block_offset & ~511, sector_end = (block_offset + DCID_MAX_RAW_SIZE + 511) & ~511;
+
+        uint8_t *file_data = (uint8_t*)malloc(sector_end);
+
+        char *xml = (char*)malloc(DCID_MAX_XML_SIZE);
+
+        int xml_size = DCID_MAX_XML_SIZE, ret, v;
+
+        /*! use the card contents written above */
+        ret = dcid_read_xml(p_dcid, xml, &xml_size);
+
+        for(v=0;v<3 && DCID_SUCCESS(ret);v++)
+        {
+            dcid_info_t dcid_info = { 0 };
+
+            dcid_t *p_dcid_emmc = 0;
+
+            dcid_trace_entry_t entries[64];
+
+            int count = 64, writes = 0, syncs = 0, e, fd, size = DCID_MAX_XML_SIZE;
+
+            /*! a patterned file, with a block table naming the dcid block */
+            for(e=0;e<sector_end;e++) { file_data[e] = (uint8_t)(e * 7); }
+
+            memset(&file_data[cfg_offset], 0, table_offset + 2*16);
+            memcpy(&file_data[cfg_offset], "Cfg*", 4);
+            memcpy(&file_data[cfg_offset + table_offset], &block_offset, 4);
+            memcpy(&file_data[cfg_offset + table_offset + 12], "dcid", 4);
+            memset(&file_data[cfg_offset + table_offset + 16], 0xFF, 4);
+
+            fd = open(emmc_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+            if(fd == -1 || write(fd, file_data, sector_end) != sector_end) { ret = DCID_FAIL; }
+
+            if(fd != -1) { close(fd); }
+
+            dcid_info.backend = dcid_backend_find(emmc_names[v]);
+
+            if(DCID_SUCCESS(ret)) { ret = dcid_create(&dcid_info, &p_dcid_emmc); }
+            if(DCID_SUCCESS(ret)) { ret = dcid_init(p_dcid_emmc, (char*)emmc_path); }
+            if(DCID_SUCCESS(ret)) { ret = dcid_trace_enable(p_dcid_emmc, 64); }
+            if(DCID_SUCCESS(ret)) { size = xml_size; ret = dcid_write_xml(p_dcid_emmc, xml, &size); }
+            if(DCID_SUCCESS(ret)) { ret = dcid_trace_read(p_dcid_emmc, entries, &count); }
+
+            for(e=0;DCID_SUCCESS(ret) && e<count;e++)
+            {
+                if(entries[e].event == DCID_IO_SYNC) { syncs++; }
+
+                if(entries[e].event != DCID_IO_WRITE) { continue; }
+
+                writes++;
+
+                if(entries[e].addr % 512 != 0 || entries[e].size % 512 != 0 || entries[e].addr < sector_beg || entries[e].addr + entries[e].size > sector_end)
+                {
+                    ret = DCID_FAIL;
+                }
+            }
+
+            if(p_dcid_emmc != 0) { dcid_close(p_dcid_emmc); p_dcid_emmc = 0; }
+
+            if(DCID_FAILED(ret) || writes != 1 || syncs != (v == 2 ? 0 : 1))
+            {
+                fprintf(stderr, "Error: unexpected %s flush (ret := %d, writes := %d, syncs := %d)\n", emmc_names[v], ret, writes, syncs);
+                ret = DCID_FAIL;
+                break;
+            }
+
+            /*! bytes outside the block, within the sectors written, are untouched */
+            {
+                uint8_t *check = (uint8_t*)malloc(sector_end);
+
+                fd = open(emmc_path, O_RDONLY);
+
+                if(check == 0 || fd == -1 || read(fd, check, sector_end) != sector_end) { ret = DCID_FAIL; }
+
+                for(e=sector_beg;DCID_SUCCESS(ret) && e<sector_end;e++)
+                {
+                    if((e < block_offset || e >= block_offset + DCID_MAX_RAW_SIZE) && check[e] != file_data[e]) { ret = DCID_FAIL; }
+                }
+
+                if(fd != -1) { close(fd); }
+                if(check != 0) { free(check); }
+            }
+
+            if(DCID_SUCCESS(ret)) { ret = dcid_create(&dcid_info, &p_dcid_emmc); }
+            if(DCID_SUCCESS(ret)) { ret = dcid_init(p_dcid_emmc, (char*)emmc_path); }
+            if(DCID_SUCCESS(ret)) { size = DCID_MAX_XML_SIZE; ret = dcid_read_xml(p_dcid_emmc, tmp_buffer, &size); }
+
+            if(p_dcid_emmc != 0) { dcid_close(p_dcid_emmc); }
+
+            if(DCID_FAILED(ret) || strcmp(xml, tmp_buffer) != 0)
+            {
+                fprintf(stderr, "Error: %s round trip failed (ret := %d)\n", emmc_names[v], ret);
+                ret = DCID_FAIL;
+                break;
+            }
+        }
+
+        unlink(emmc_path);
+
+        free(file_data);
+        free(xml);
+
+        if(DCID_FAILED(ret)) { goto cleanup; }
+    }
+
+    printf("Testing on-disk cache...\n");
+
+    /*! a second reader takes the rendered XML from the cache, reading only the card identity
+     *  and record area rather than the whole image. a write, or a card reprogrammed elsewhere
+     *  under the same serial number, is never served from a stale cache file */
+    {
+        static const char *card_xml[3] =
+        {
+            "<card><vend>0A0B</vend><info><sern>0C0D0E0F</sern></info></card>",
+            "<card><vend>0A0B</vend><info><sern>0C0D0E1F</sern></info></card>",
+            "<card><vend>0A0B</vend><info><sern>0C0D0E2F</sern></info></card>",
+        };
+
+        /*! reads a distinct serial number, so the card is not treated as blank */
+        static const uint8_t ident[16] = { 0x01, 0x00, 0xC0, 0xFF, 0xEE, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01 };
+
+        static const char *card_path = "/tmp/dcid-test-cache.bin";
+
+        char cache_dir[] = "/tmp/dcid-test-cache-XXXXXX", cache_path[128];
+
+        char *expected[3] = { 0, 0, 0 };
+
+        int raw_sizes[3] = { 0, 0, 0 };
+
+        dcid_info_t dcid_info = { 0 };
+
+        dcid_t *p_dcid_card = 0;
+
+        int ret = DCID_OK, v, fd;
+
+        unlink(card_path);
+
+        if(mkdtemp(cache_dir) == 0) { ret = DCID_FAIL; }
+
+        /*! each document as dcid_read_xml renders it */
+        for(v=0;v<3 && DCID_SUCCESS(ret);v++)
+        {
+            uint8_t raw[DCID_MAX_RAW_SIZE];
+
+            int raw_size = DCID_MAX_RAW_SIZE, size = DCID_MAX_XML_SIZE;
+
+            expected[v] = (char*)malloc(DCID_MAX_XML_SIZE);
+
+            ret = dcid_encode_xml(card_xml[v], raw, &raw_size);
+
+            if(DCID_SUCCESS(ret)) { ret = dcid_decode_image(raw, raw_size, expected[v], &size); }
+
+            raw_sizes[v] = raw_size;
+        }
+
+        /*! program the card, with no cache involved */
+        dcid_info.backend = dcid_backend_find("file");
+
+        if(DCID_SUCCESS(ret)) { ret = dcid_create(&dcid_info, &p_dcid_card); }
+        if(DCID_SUCCESS(ret)) { ret = dcid_init(p_dcid_card, (char*)card_path); }
+        if(DCID_SUCCESS(ret)) { int size = strlen(card_xml[0]); ret = dcid_write_xml(p_dcid_card, (char*)card_xml[0], &size); }
+
+        if(p_dcid_card != 0) { dcid_close(p_dcid_card); p_dcid_card = 0; }
+
+        fd = open(card_path, O_WRONLY);
+
+        if(fd == -1 || pwrite(fd, ident, sizeof(ident), DCID_REV_LOC) != sizeof(ident)) { ret = DCID_FAIL; }
+
+        if(fd != -1) { close(fd); }
+
+        snprintf(cache_path, sizeof(cache_path), "%s/dcid-", cache_dir);
+
+        for(v=0;v<(int)sizeof(ident);v++) { sprintf(&cache_path[strlen(cache_path)], "%.02X", ident[v]); }
+
+        strcat(cache_path, ".cache");
+
+        dcid_info.cache_dir = cache_dir;
+
+        /*! miss, then hit, then a write through the cache, then a rewrite behind its back */
+        for(v=0;v<5 && DCID_SUCCESS(ret);v++)
+        {
+            static const int expect_hit[5] = { 0, 1, 0, 1, 0 };
+            static const int expect_xml[5] = { 0, 0, 1, 1, 2 };
+
+            dcid_stats_t stats = { 0 };
+
+            int size = DCID_MAX_XML_SIZE;
+
+            if(v == 4)
+            {
+                dcid_info_t plain_info = { 0 };
+
+                plain_info.backend = dcid_backend_find("file");
+
+                ret = dcid_create(&plain_info, &p_dcid_card);
+
+                if(DCID_SUCCESS(ret)) { ret = dcid_init(p_dcid_card, (char*)card_path); }
+                if(DCID_SUCCESS(ret)) { size = strlen(card_xml[2]); ret = dcid_write_xml(p_dcid_card, (char*)card_xml[2], &size); }
+
+                if(p_dcid_card != 0) { dcid_close(p_dcid_card); p_dcid_card = 0; }
+
+                size = DCID_MAX_XML_SIZE;
+            }
+
+            if(DCID_SUCCESS(ret)) { ret = dcid_create(&dcid_info, &p_dcid_card); }
+            if(DCID_SUCCESS(ret)) { ret = dcid_init(p_dcid_card, (char*)card_path); }
+            if(DCID_SUCCESS(ret)) { ret = dcid_read_xml(p_dcid_card, tmp_buffer, &size); }
+            if(DCID_SUCCESS(ret)) { ret = dcid_get_stats(p_dcid_card, &stats); }
+
+            if(DCID_FAILED(ret) || strcmp(expected[expect_xml[v]], tmp_buffer) != 0 || (p_dcid_card->cache_xml != 0) != expect_hit[v] ||
+               (expect_hit[v] && stats.read_bytes != sizeof(ident) + raw_sizes[expect_xml[v]]) ||
+               (expect_hit[v] && stats.read_bytes >= DCID_MAX_RAW_SIZE) || access(cache_path, F_OK) != 0)
+            {
+                fprintf(stderr, "Error: unexpected cache behaviour (step := %d, ret := %d, read := %u)\n", v, ret, stats.read_bytes);
+                ret = DCID_FAIL;
+            }
+
+            /*! the write drops the cache file, and the next read after it stores a new one */
+            if(DCID_SUCCESS(ret) && v == 1)
+            {
+                size = strlen(card_xml[1]);
+
+                ret = dcid_write_xml(p_dcid_card, (char*)card_xml[1], &size);
+
+                if(DCID_SUCCESS(ret) && access(cache_path, F_OK) == 0) { fprintf(stderr, "Error: cache file survived a write\n"); ret = DCID_FAIL; }
+            }
+
+            if(p_dcid_card != 0) { dcid_close(p_dcid_card); p_dcid_card = 0; }
+        }
+
+        for(v=0;v<3;v++) { if(expected[v] != 0) { free(expected[v]); } }
+
+        unlink(cache_path);
+        rmdir(cache_dir);
+        unlink(card_path);
+
+        if(DCID_FAILED(ret))
+        {
+            fprintf(stderr, "Error: on-disk cache failed (ret := %d)\n", ret);
+            goto cleanup;
+        }
     }
 
+    printf("Testing chumby_accel requests...\n");
+
+    /*! against a stub driver, with and without the bulk commands, a flush takes a single
+     *  unlock window and the XML reads back the same */
+    {
+        static const char *accel_path = "/tmp/dcid-test-accel.bin";
+
+        dcid_info_t dcid_info = { 0 };
+
+        char *xml = (char*)malloc(DCID_MAX_XML_SIZE);
+
+        int xml_size = DCID_MAX_XML_SIZE, bulk;
+
+        /*! use the card contents written above */
+        int ret = dcid_read_xml(p_dcid, xml, &xml_size);
+
+        /*! the backend opens a real file, though all requests go to the stub */
+        FILE *file = fopen(accel_path, "wb");
+
+        if(file != 0) { fclose(file); } else { ret = DCID_FAIL; }
+
+        dcid_accel_set_ioctl(stub_accel_ioctl);
+
+        dcid_info.backend = dcid_backend_find("ironforge");
+
+        for(bulk=1;bulk>=0 && DCID_SUCCESS(ret);bulk--)
+        {
+            dcid_t *p_dcid_accel = 0;
+
+            int size = DCID_MAX_XML_SIZE;
+
+            memset(&stub_accel, 0, sizeof(stub_accel));
+
+            stub_accel.bulk = bulk;
+            stub_accel.locked = 1;
+
+            ret = dcid_create(&dcid_info, &p_dcid_accel);
+
+            if(DCID_SUCCESS(ret)) { ret = dcid_init(p_dcid_accel, (char*)accel_path); }
+            if(DCID_SUCCESS(ret)) { ret = dcid_write_xml(p_dcid_accel, xml, &xml_size); }
+            if(DCID_SUCCESS(ret)) { ret = dcid_read_xml(p_dcid_accel, tmp_buffer, &size); }
+
+            if(p_dcid_accel != 0) { dcid_close(p_dcid_accel); }
+
+            if(DCID_FAILED(ret) || strcmp(xml, tmp_buffer) != 0 || stub_accel.unlocks != 1 || !stub_accel.locked ||
+               stub_accel.locked_writes != 0 || (stub_accel.bulk_requests > 0) != bulk || (stub_accel.byte_requests > 0) == bulk)
+            {
+                fprintf(stderr, "Error: chumby_accel round trip failed (ret := %d, bulk := %d, unlocks := %d, bulk requests := %d, byte requests := %d)\n",
+                        ret, bulk, stub_accel.unlocks, stub_accel.bulk_requests, stub_accel.byte_requests);
+                ret = DCID_FAIL;
+            }
+        }
+
+        dcid_accel_set_ioctl(0);
+
+        unlink(accel_path);
+
+        free(xml);
+
+        if(DCID_FAILED(ret)) { goto cleanup; }
+    }
+
+    printf("Testing background flush...\n");
+
+    /*! a background flush signals completion both ways and reads back. a cancelled one
+     *  stops part way, and leaves whatever it did not write staged for the next flush */
+    {
+        static const char *staged = "<card><vend>0A0B</vend><info><sern>0C0D0E0F</sern></info></card>";
+
+        char *xml = (char*)malloc(DCID_MAX_XML_SIZE);
+        char *expected = (char*)malloc(DCID_MAX_XML_SIZE);
+
+        uint8_t raw[DCID_MAX_RAW_SIZE];
+
+        int xml_size = DCID_MAX_XML_SIZE, raw_size = DCID_MAX_RAW_SIZE, size = DCID_MAX_XML_SIZE;
+        int fd = -1, done = 0, total = 0;
+
+        /*! keep the card contents written above, to put back afterwards */
+        int ret = dcid_read_xml(p_dcid, xml, &xml_size);
+
+        /*! the staged document as dcid_read_xml renders it */
+        if(DCID_SUCCESS(ret)) { ret = dcid_encode_xml(staged, raw, &raw_size); }
+        if(DCID_SUCCESS(ret)) { ret = dcid_decode_image(raw, raw_size, expected, &size); }
+
+        if(DCID_SUCCESS(ret)) { size = strlen(staged); ret = dcid_stage_xml(p_dcid, (char*)staged, &size); }
+        if(DCID_SUCCESS(ret)) { ret = dcid_flush_fd(p_dcid, &fd); }
+        if(DCID_SUCCESS(ret)) { ret = dcid_write_flush_async(p_dcid, flush_done, 0); }
+
+        if(DCID_SUCCESS(ret))
+        {
+            struct timeval timeout = { 10, 0 };
+
+            fd_set fds;
+
+            FD_ZERO(&fds);
+            FD_SET(fd, &fds);
+
+            if(select(fd + 1, &fds, 0, 0, &timeout) != 1) { ret = DCID_FAIL; }
+        }
+
+        if(DCID_SUCCESS(ret)) { ret = dcid_flush_wait(p_dcid); }
+        if(DCID_SUCCESS(ret)) { ret = dcid_flush_progress(p_dcid, &done, &total); }
+        if(DCID_SUCCESS(ret)) { size = DCID_MAX_XML_SIZE; ret = dcid_read_xml(p_dcid, tmp_buffer, &size); }
+
+        if(DCID_FAILED(ret) || flush_calls != 1 || flush_result != DCID_OK || total == 0 || done != total || strcmp(expected, tmp_buffer) != 0)
+        {
+            fprintf(stderr, "Error: background flush failed (ret := %d, calls := %d, result := %d, done := %d/%d)\n", ret, flush_calls, flush_result, done, total);
+            free(xml);
+            free(expected);
+            goto cleanup;
+        }
+
+        /*! put the card contents back */
+        ret = dcid_write_xml(p_dcid, xml, &xml_size);
+
+        if(DCID_FAILED(ret))
+        {
+            fprintf(stderr, "Error: dcid_write_xml failed (%s)\n", DCID_RETURN_CODE_LOOKUP[ret]);
+            free(xml);
+            free(expected);
+            goto cleanup;
+        }
+
+        /*! a file backend writing a few bytes at a time, which cancels the flush from inside
+         *  its first write, so the flush always stops part way */
+        {
+            static const char *cancel_path = "/tmp/dcid-test-cancel.bin";
+
+            dcid_backend_t cancel_backend = dcid_backend_file;
+
+            dcid_info_t dcid_info = { 0 };
+
+            dcid_t *p_dcid_cancel = 0;
+
+            cancel_backend.caps.write_page = 16;
+            cancel_backend.write_block = cancel_write_block;
+
+            dcid_info.backend = &cancel_backend;
+
+            unlink(cancel_path);
+
+            ret = dcid_create(&dcid_info, &p_dcid_cancel);
+
+            if(DCID_SUCCESS(ret)) { ret = dcid_init(p_dcid_cancel, (char*)cancel_path); }
+            if(DCID_SUCCESS(ret)) { ret = dcid_stage_xml(p_dcid_cancel, xml, &xml_size); }
+            if(DCID_SUCCESS(ret)) { ret = dcid_write_flush_async(p_dcid_cancel, 0, 0); }
+            if(DCID_SUCCESS(ret)) { ret = dcid_flush_wait(p_dcid_cancel); }
+
+            if(ret == DCID_CANCELLED) { ret = dcid_flush_progress(p_dcid_cancel, &done, &total); }
+            else { ret = DCID_FAIL; }
+
+            if(DCID_SUCCESS(ret) && (total <= 16 || done >= total)) { ret = DCID_FAIL; }
+
+            /*! the next flush writes the rest */
+            if(DCID_SUCCESS(ret)) { ret = dcid_write_flush(p_dcid_cancel); }
+            if(DCID_SUCCESS(ret)) { size = DCID_MAX_XML_SIZE; ret = dcid_read_xml(p_dcid_cancel, tmp_buffer, &size); }
+
+            if(p_dcid_cancel != 0) { dcid_close(p_dcid_cancel); }
+
+            unlink(cancel_path);
+
+            if(DCID_FAILED(ret) || strcmp(xml, tmp_buffer) != 0)
+            {
+                fprintf(stderr, "Error: cancelled background flush failed (ret := %d, done := %d/%d)\n", ret, done, total);
+                free(xml);
+                free(expected);
+                goto cleanup;
+            }
+        }
+
+        free(xml);
+        free(expected);
+    }
+
+    printf("Testing streamed XML...\n");
+
+    /*! a document larger than DCID_MAX_XML_SIZE, fed a few bytes at a time, writes the same
+     *  card contents as the compact document it pads out */
+    {
+        static const char *compact = "<card><vend>0A0B</vend><info><sern>0C0D0E0F</sern></info></card>";
+
+        char *xml = (char*)malloc(DCID_MAX_XML_SIZE);
+        char *expected = (char*)malloc(DCID_MAX_XML_SIZE);
+        char *padded = (char*)malloc(DCID_MAX_XML_SIZE*4);
+
+        uint8_t raw[DCID_MAX_RAW_SIZE];
+
+        int xml_size = DCID_MAX_XML_SIZE, raw_size = DCID_MAX_RAW_SIZE, size = DCID_MAX_XML_SIZE;
+        int padded_size = 0, pos = 0;
+
+        /*! keep the card contents written above, to put back afterwards */
+        int ret = dcid_read_xml(p_dcid, xml, &xml_size);
+
+        /*! the compact document as dcid_read_xml renders it */
+        if(DCID_SUCCESS(ret)) { ret = dcid_encode_xml(compact, raw, &raw_size); }
+        if(DCID_SUCCESS(ret)) { ret = dcid_decode_image(raw, raw_size, expected, &size); }
+
+        /*! pad out the whitespace after every tag */
+        {
+            const char *src;
+
+            for(src=compact;*src != '\0';src++)
+            {
+                padded[padded_size++] = *src;
+
+                if(*src != '>') { continue; }
+
+                memset(&padded[padded_size], ' ', 600);
+
+                padded_size += 600;
+
+                padded[padded_size++] = '\n';
+            }
+        }
+
+        /*! nothing to feed before the document is begun */
+        if(DCID_SUCCESS(ret) && dcid_write_feed(p_dcid, padded, padded_size) != DCID_INVALID_CALL) { ret = DCID_FAIL; }
+
+        if(DCID_SUCCESS(ret)) { ret = dcid_write_begin(p_dcid); }
+
+        while(DCID_SUCCESS(ret) && pos < padded_size)
+        {
+            int chunk = (padded_size - pos < 7) ? padded_size - pos : 7;
+
+            ret = dcid_write_feed(p_dcid, &padded[pos], chunk);
+
+            pos += chunk;
+        }
+
+        if(DCID_SUCCESS(ret)) { ret = dcid_write_end(p_dcid, 1); }
+        if(DCID_SUCCESS(ret)) { size = DCID_MAX_XML_SIZE; ret = dcid_read_xml(p_dcid, tmp_buffer, &size); }
+
+        if(DCID_FAILED(ret) || padded_size <= DCID_MAX_XML_SIZE || strcmp(expected, tmp_buffer) != 0)
+        {
+            fprintf(stderr, "Error: streamed XML failed (ret := %d)\n", ret);
+            free(xml);
+            free(expected);
+            free(padded);
+            goto cleanup;
+        }
+
+        /*! a stream cut short inside a record, in a tag or in its data, fails and leaves the card alone */
+        {
+            static const char *truncated[2] = { "<card><vend>0A0B</vend><info><se", "<card><vend>0A0B</vend><info><sern>0C0D" };
+
+            int v;
+
+            for(v=0;v<2;v++)
+            {
+                ret = dcid_write_begin(p_dcid);
+
+                if(DCID_SUCCESS(ret)) { ret = dcid_write_feed(p_dcid, truncated[v], strlen(truncated[v])); }
+                if(DCID_SUCCESS(ret)) { ret = (dcid_write_end(p_dcid, 1) == DCID_FAIL) ? DCID_OK : DCID_FAIL; }
+                if(DCID_SUCCESS(ret)) { size = DCID_MAX_XML_SIZE; ret = dcid_read_xml(p_dcid, tmp_buffer, &size); }
+
+                if(DCID_FAILED(ret) || strcmp(expected, tmp_buffer) != 0)
+                {
+                    fprintf(stderr, "Error: truncated stream was committed:\n %s\n", truncated[v]);
+                    free(xml);
+                    free(expected);
+                    free(padded);
+                    goto cleanup;
+                }
+            }
+        }
+
+        /*! put the card contents back */
+        ret = dcid_write_xml(p_dcid, xml, &xml_size);
+
+        if(DCID_FAILED(ret))
+        {
+            fprintf(stderr, "Error: dcid_write_xml failed (%s)\n", DCID_RETURN_CODE_LOOKUP[ret]);
+            free(xml);
+            free(expected);
+            free(padded);
+            goto cleanup;
+        }
+
+        free(xml);
+        free(expected);
+        free(padded);
+    }
+
+    printf("Testing record iterator...\n");
+
+    /*! walk the records of the XML written above */
+    {
+        dcid_iter_t iter;
+
+        static const uint8_t nod4_data[2] = { 0xFF, 0xAA };
+
+        int ret = dcid_iter_begin(p_dcid, &iter);
+
+        if(DCID_SUCCESS(ret)) { ret = (memcmp(iter.tag, "nod1", 4) == 0 && iter.is_container) ? DCID_OK : DCID_FAIL; }
+        if(DCID_SUCCESS(ret)) { ret = dcid_iter_enter(&iter); }
+        if(DCID_SUCCESS(ret)) { ret = (memcmp(iter.tag, "nod2", 4) == 0 && iter.size == 16 && iter.data[15] == 0xFF) ? DCID_OK : DCID_FAIL; }
+        if(DCID_SUCCESS(ret)) { ret = (dcid_iter_enter(&iter) == DCID_INVALID_CALL) ? DCID_OK : DCID_FAIL; }
+        if(DCID_SUCCESS(ret)) { ret = dcid_iter_next(&iter); }
+        if(DCID_SUCCESS(ret)) { ret = (memcmp(iter.tag, "nod3", 4) == 0 && iter.is_container) ? DCID_OK : DCID_FAIL; }
+        if(DCID_SUCCESS(ret)) { ret = dcid_iter_enter(&iter); }
+        if(DCID_SUCCESS(ret)) { ret = (memcmp(iter.tag, "nod4", 4) == 0 && iter.size == 2 && memcmp(iter.data, nod4_data, 2) == 0) ? DCID_OK : DCID_FAIL; }
+        if(DCID_SUCCESS(ret)) { ret = dcid_iter_next(&iter); }
+        if(DCID_SUCCESS(ret)) { ret = (memcmp(iter.tag, "nod5", 4) == 0) ? DCID_OK : DCID_FAIL; }
+        if(DCID_SUCCESS(ret)) { ret = (dcid_iter_next(&iter) == DCID_NOT_FOUND) ? DCID_OK : DCID_FAIL; }
+        if(DCID_SUCCESS(ret)) { ret = dcid_iter_leave(&iter); }
+        if(DCID_SUCCESS(ret)) { ret = (memcmp(iter.tag, "nod3", 4) == 0 && dcid_iter_next(&iter) == DCID_NOT_FOUND) ? DCID_OK : DCID_FAIL; }
+        if(DCID_SUCCESS(ret)) { ret = dcid_iter_leave(&iter); }
+        if(DCID_SUCCESS(ret)) { ret = (memcmp(iter.tag, "nod1", 4) == 0 && dcid_iter_next(&iter) == DCID_NOT_FOUND) ? DCID_OK : DCID_FAIL; }
+
+        if(DCID_FAILED(ret))
+        {
+            fprintf(stderr, "Error: dcid_iter walk failed at offset %d (ret := %d)\n", iter.offset, ret);
+            goto cleanup;
+        }
+    }
+
+    printf("Testing record lookup...\n");
+
+    /*! look up records of the XML written above by path */
+    {
+        uint8_t data[16];
+
+        int size = sizeof(data);
+
+        int ret = dcid_get(p_dcid, "nod1/nod3/nod5", data, &size);
+
+        if(DCID_FAILED(ret) || size != 2 || data[0] != 0xEE || data[1] != 0xBB)
+        {
+            fprintf(stderr, "Error: dcid_get(nod1/nod3/nod5) failed (ret := %d, size := %d)\n", ret, size);
+            goto cleanup;
+        }
+
+        size = sizeof(data);
+
+        if(dcid_get(p_dcid, "nod1/nod4", data, &size) != DCID_NOT_FOUND)
+        {
+            fprintf(stderr, "Error: dcid_get(nod1/nod4) found a record that does not exist\n");
+            goto cleanup;
+        }
+
+        size = 1;
+
+        if(dcid_get(p_dcid, "nod1/nod2", data, &size) != DCID_BUFFER_TOO_SMALL || size != 16)
+        {
+            fprintf(stderr, "Error: dcid_get(nod1/nod2) did not report required size\n");
+            goto cleanup;
+        }
+
+        /*! a fresh instance has no image loaded, and walks record headers on the device instead */
+        {
+            dcid_info_t dcid_info = { 0 };
+
+            dcid_t *p_dcid_fresh = 0;
+
+            size = sizeof(data);
+
+            ret = dcid_create(&dcid_info, &p_dcid_fresh);
+
+            if(DCID_SUCCESS(ret)) { ret = dcid_init(p_dcid_fresh, DCID_DEVICE_PATH); }
+            if(DCID_SUCCESS(ret)) { ret = dcid_get(p_dcid_fresh, "/nod1/nod3/nod5", data, &size); }
+
+            if(p_dcid_fresh != 0) { dcid_close(p_dcid_fresh); }
+
+            if(DCID_FAILED(ret) || size != 2 || data[0] != 0xEE || data[1] != 0xBB)
+            {
+                fprintf(stderr, "Error: dcid_get(/nod1/nod3/nod5) failed on fresh instance (ret := %d, size := %d)\n", ret, size);
+                goto cleanup;
+            }
+        }
+    }
+
+    printf("Testing daemon requests...\n");
+
+    /*! a forked server answers reads, lookups and writes over its socket, keeps serving a
+     *  second client while the first stays connected, and answers or drops malformed
+     *  requests without going down */
+    {
+        static const char *card_xml[2] =
+        {
+            "<card><vend>0A0B</vend><info><sern>0C0D0E0F</sern></info></card>",
+            "<card><vend>1A1B</vend><info><sern>1C1D1E1F</sern></info></card>",
+        };
+
+        static const char *card_path = "/tmp/dcid-test-daemon.bin";
+
+        char sock_dir[] = "/tmp/dcid-test-daemon-XXXXXX", sock_path[64];
+
+        char *expected[2] = { 0, 0 };
+
+        dcid_info_t dcid_info = { 0 };
+
+        dcid_t *p_dcid_card = 0;
+
+        dcid_daemon_msg_t msg;
+
+        uint8_t data[8];
+
+        pid_t pid = -1;
+
+        int ret = DCID_OK, fd = -1, fd2 = -1, size, v;
+
+        unlink(card_path);
+
+        if(mkdtemp(sock_dir) == 0) { ret = DCID_FAIL; }
+
+        snprintf(sock_path, sizeof(sock_path), "%s/dcid.sock", sock_dir);
+
+        /*! each document as dcid_read_xml renders it */
+        for(v=0;v<2 && DCID_SUCCESS(ret);v++)
+        {
+            uint8_t raw[DCID_MAX_RAW_SIZE];
+
+            int raw_size = DCID_MAX_RAW_SIZE;
+
+            expected[v] = (char*)malloc(DCID_MAX_XML_SIZE);
+
+            size = DCID_MAX_XML_SIZE;
+
+            ret = dcid_encode_xml(card_xml[v], raw, &raw_size);
+
+            if(DCID_SUCCESS(ret)) { ret = dcid_decode_image(raw, raw_size, expected[v], &size); }
+        }
+
+        /*! program the card the server will own */
+        dcid_info.backend = dcid_backend_find("file");
+
+        if(DCID_SUCCESS(ret)) { ret = dcid_create(&dcid_info, &p_dcid_card); }
+        if(DCID_SUCCESS(ret)) { ret = dcid_init(p_dcid_card, (char*)card_path); }
+        if(DCID_SUCCESS(ret)) { size = strlen(card_xml[0]); ret = dcid_write_xml(p_dcid_card, (char*)card_xml[0], &size); }
+
+        if(p_dcid_card != 0) { dcid_close(p_dcid_card); p_dcid_card = 0; }
+
+        /*! the server runs until killed */
+        if(DCID_SUCCESS(ret))
+        {
+            pid = fork();
+
+            if(pid == 0)
+            {
+                if(DCID_SUCCESS(dcid_create(&dcid_info, &p_dcid_card)) && DCID_SUCCESS(dcid_init(p_dcid_card, (char*)card_path)))
+                {
+                    dcid_daemon_run(p_dcid_card, sock_path);
+                }
+
+                _exit(1);
+            }
+
+            if(pid == -1) { ret = DCID_FAIL; }
+        }
+
+        for(v=0;v<500 && DCID_SUCCESS(ret) && DCID_FAILED(dcid_client_open(sock_path, &fd));v++) { usleep(10000); }
+
+        if(fd == -1) { ret = DCID_FAIL; }
+
+        if(DCID_SUCCESS(ret)) { size = DCID_MAX_XML_SIZE; ret = dcid_client_read_xml(fd, tmp_buffer, &size); }
+
+        if(DCID_SUCCESS(ret) && strcmp(expected[0], tmp_buffer) != 0) { fprintf(stderr, "Error: daemon read_xml mismatch\n"); ret = DCID_FAIL; }
+
+        if(DCID_SUCCESS(ret)) { size = sizeof(data); ret = dcid_client_get(fd, "card/vend", data, &size); }
+
+        if(DCID_SUCCESS(ret) && (size != 2 || data[0] != 0x0A || data[1] != 0x0B)) { fprintf(stderr, "Error: daemon get mismatch\n"); ret = DCID_FAIL; }
+
+        if(DCID_SUCCESS(ret)) { size = sizeof(data); if(dcid_client_get(fd, "card/none", data, &size) != DCID_NOT_FOUND) { ret = DCID_FAIL; } }
+
+        /*! the first client stays connected, and the second is still answered promptly */
+        if(DCID_SUCCESS(ret)) { ret = dcid_client_open(sock_path, &fd2); }
+
+        if(DCID_SUCCESS(ret))
+        {
+            struct timeval tv = { 1, 0 };
+
+            setsockopt(fd2, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+            size = DCID_MAX_XML_SIZE;
+
+            ret = dcid_client_read_xml(fd2, tmp_buffer, &size);
+        }
+
+#ifdef DCID_ALLOW_WRITE
+        if(DCID_SUCCESS(ret)) { size = strlen(card_xml[1]); ret = dcid_client_write_xml(fd, (char*)card_xml[1], &size); }
+        if(DCID_SUCCESS(ret) && size != (int)strlen(card_xml[1])) { fprintf(stderr, "Error: daemon write_xml consumed %d bytes\n", size); ret = DCID_FAIL; }
+        if(DCID_SUCCESS(ret)) { size = DCID_MAX_XML_SIZE; ret = dcid_client_read_xml(fd2, tmp_buffer, &size); }
+
+        if(DCID_SUCCESS(ret) && strcmp(expected[1], tmp_buffer) != 0) { fprintf(stderr, "Error: daemon write_xml did not read back\n"); ret = DCID_FAIL; }
+#else
+        if(DCID_SUCCESS(ret)) { size = strlen(card_xml[1]); if(dcid_client_write_xml(fd, (char*)card_xml[1], &size) != DCID_ACCESS_DENIED) { ret = DCID_FAIL; } }
+#endif
+
+        /*! a path without its terminator is refused, and an unknown request is not implemented */
+        if(DCID_SUCCESS(ret))
+        {
+            msg.op = DCID_DAEMON_GET; msg.size = sizeof(data); msg.len = 4;
+
+            if(send(fd2, &msg, sizeof(msg), 0) != sizeof(msg) || send(fd2, "card", 4, 0) != 4 ||
+               recv(fd2, &msg, sizeof(msg), MSG_WAITALL) != sizeof(msg) || msg.op != DCID_INVALID_PARAM || msg.len != 0)
+            {
+                fprintf(stderr, "Error: daemon accepted an unterminated path\n");
+                ret = DCID_FAIL;
+            }
+        }
+
+        if(DCID_SUCCESS(ret))
+        {
+            msg.op = 0x7F; msg.size = 0; msg.len = 0;
+
+            if(send(fd2, &msg, sizeof(msg), 0) != sizeof(msg) || recv(fd2, &msg, sizeof(msg), MSG_WAITALL) != sizeof(msg) || msg.op != DCID_NOTIMPL)
+            {
+                fprintf(stderr, "Error: daemon accepted an unknown request\n");
+                ret = DCID_FAIL;
+            }
+        }
+
+        /*! an oversized request drops the connection, and the server carries on */
+        if(DCID_SUCCESS(ret))
+        {
+            msg.op = DCID_DAEMON_WRITE_XML; msg.size = 0; msg.len = DCID_MAX_XML_SIZE + 1;
+
+            if(send(fd2, &msg, sizeof(msg), 0) != sizeof(msg) || recv(fd2, &msg, sizeof(msg), MSG_WAITALL) != 0)
+            {
+                fprintf(stderr, "Error: daemon kept a client after an oversized request\n");
+                ret = DCID_FAIL;
+            }
+        }
+
+        if(DCID_SUCCESS(ret)) { size = sizeof(data); ret = dcid_client_get(fd, "card/vend", data, &size); }
+
+        /*! as root, check that other users may read but not write, and that a socket planted
+         *  by another user is not trusted */
+        if(DCID_SUCCESS(ret) && geteuid() == 0)
+        {
+            pid_t user_pid;
+            int status = 1;
+
+            chmod(sock_dir, 0755);
+
+            user_pid = fork();
+
+            if(user_pid == 0)
+            {
+                int user_fd = -1;
+
+                if(setgid(65534) != 0 || setuid(65534) != 0) { _exit(1); }
+
+                if(DCID_FAILED(dcid_client_open(sock_path, &user_fd))) { _exit(2); }
+
+                size = DCID_MAX_XML_SIZE;
+
+                if(DCID_FAILED(dcid_client_read_xml(user_fd, tmp_buffer, &size))) { _exit(3); }
+
+                size = strlen(card_xml[0]);
+
+                _exit((dcid_client_write_xml(user_fd, (char*)card_xml[0], &size) == DCID_ACCESS_DENIED) ? 0 : 4);
+            }
+
+            if(user_pid == -1 || waitpid(user_pid, &status, 0) != user_pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            {
+                fprintf(stderr, "Error: daemon let another user write (status := %d)\n", status);
+                ret = DCID_FAIL;
+            }
+
+            /*! a listening socket belonging to another user */
+            if(DCID_SUCCESS(ret))
+            {
+                struct sockaddr_un addr;
+
+                char forged_path[80];
+
+                int forged_fd = socket(AF_UNIX, SOCK_STREAM, 0), client_fd = -1;
+
+                snprintf(forged_path, sizeof(forged_path), "%s/forged.sock", sock_dir);
+
+                memset(&addr, 0, sizeof(addr));
+                addr.sun_family = AF_UNIX;
+                strcpy(addr.sun_path, forged_path);
+
+                if(forged_fd == -1 || bind(forged_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(forged_fd, 1) != 0 ||
+                   chown(forged_path, 65534, 65534) != 0 || dcid_client_open(forged_path, &client_fd) != DCID_ACCESS_DENIED)
+                {
+                    fprintf(stderr, "Error: client trusted a socket owned by another user\n");
+                    ret = DCID_FAIL;
+                }
+
+                if(client_fd != -1) { dcid_client_close(client_fd); }
+                if(forged_fd != -1) { close(forged_fd); }
+
+                unlink(forged_path);
+            }
+        }
+
+        if(fd != -1) { dcid_client_close(fd); }
+        if(fd2 != -1) { dcid_client_close(fd2); }
+
+        if(pid > 0)
+        {
+            kill(pid, SIGTERM);
+            waitpid(pid, 0, 0);
+        }
+
+        for(v=0;v<2;v++) { if(expected[v] != 0) { free(expected[v]); } }
+
+        unlink(sock_path);
+        rmdir(sock_dir);
+        unlink(card_path);
+
+        if(DCID_FAILED(ret))
+        {
+            fprintf(stderr, "Error: daemon requests failed (ret := %d)\n", ret);
+            goto cleanup;
+        }
+    }
+
+    printf("Testing shared memory snapshot...\n");
+
+    /*! publish, look up through a read-only mapping, and check that a write is picked up */
+    {
+        static const char *shm_path = "/tmp/dcid-test.shm";
+
+        struct _dcid_shm_t *p_shm = 0;
+
+        uint8_t data[16];
+        uint32_t gen_before = 0, gen_after = 0;
+        int size = sizeof(data);
+
+        int ret = dcid_shm_publish(p_dcid, shm_path);
+
+        if(DCID_SUCCESS(ret)) { ret = dcid_shm_attach(shm_path, &p_shm); }
+        if(DCID_SUCCESS(ret)) { ret = dcid_shm_generation(p_shm, &gen_before); }
+        if(DCID_SUCCESS(ret)) { ret = dcid_shm_get(p_shm, "nod1/nod3/nod5", data, &size); }
+
+        if(DCID_FAILED(ret) || size != 2 || data[0] != 0xEE || data[1] != 0xBB)
+        {
+            fprintf(stderr, "Error: dcid_shm_get(nod1/nod3/nod5) failed (ret := %d, size := %d)\n", ret, size);
+            if(p_shm != 0) { dcid_shm_detach(p_shm); }
+            goto cleanup;
+        }
+
+        strcpy(tmp_buffer, "<nod1><nod2>00112233445566778899AABBCCDDEEFF</nod2><nod3><nod4>FFAA</nod4><nod5>1234</nod5></nod3></nod1>");
+
+        size = strlen(tmp_buffer)+1;
+
+        ret = dcid_write_xml(p_dcid, tmp_buffer, &size);
+
+        size = sizeof(data);
+
+        if(DCID_SUCCESS(ret)) { ret = dcid_shm_generation(p_shm, &gen_after); }
+        if(DCID_SUCCESS(ret)) { ret = dcid_shm_get(p_shm, "nod1/nod3/nod5", data, &size); }
+
+        dcid_shm_detach(p_shm);
+        unlink(shm_path);
+
+        if(DCID_FAILED(ret) || gen_after == gen_before || size != 2 || data[0] != 0x12 || data[1] != 0x34)
+        {
+            fprintf(stderr, "Error: shared memory snapshot not updated after write (ret := %d, size := %d)\n", ret, size);
+            goto cleanup;
+        }
+    }
+
+    /*! a link planted at the segment path is refused, and the file it points at is left alone */
+    {
+        static const char *shm_path = "/tmp/dcid-test-link.shm", *target_path = "/tmp/dcid-test-target";
+
+        dcid_info_t dcid_info = { 0 };
+
+        dcid_t *p_dcid_fresh = 0;
+
+        struct stat st;
+
+        int ret = dcid_create(&dcid_info, &p_dcid_fresh);
+
+        if(DCID_SUCCESS(ret)) { ret = dcid_init(p_dcid_fresh, DCID_DEVICE_PATH); }
+
+        FILE *target = fopen(target_path, "w");
+
+        if(target == 0 || fputs("target", target) < 0) { ret = DCID_FAIL; }
+
+        if(target != 0) { fclose(target); }
+
+        unlink(shm_path);
+
+        if(DCID_SUCCESS(ret) && symlink(target_path, shm_path) != 0) { ret = DCID_FAIL; }
+        if(DCID_SUCCESS(ret) && dcid_shm_publish(p_dcid_fresh, shm_path) != DCID_ACCESS_DENIED) { ret = DCID_FAIL; }
+        if(DCID_SUCCESS(ret) && (stat(target_path, &st) != 0 || st.st_size != 6)) { ret = DCID_FAIL; }
+
+        if(p_dcid_fresh != 0) { dcid_close(p_dcid_fresh); }
+
+        unlink(shm_path);
+        unlink(target_path);
+
+        if(DCID_FAILED(ret))
+        {
+            fprintf(stderr, "Error: shared memory snapshot followed a planted link\n");
+            goto cleanup;
+        }
+    }
+
+    printf("Testing simulated devices...\n");
+
+    /*! two simulated instances open at once each keep their own card, in memory and on disk */
+    {
+        static const char *card_xml[2] =
+        {
+            "<card><vend>0A0B</vend><info><sern>0C0D0E0F</sern></info></card>",
+            "<card><vend>1A1B</vend></card>",
+        };
+
+        static const char *card_path[2] = { "/tmp/dcid-test-sim-a.bin", "/tmp/dcid-test-sim-b.bin" };
+
+        char *expected[2] = { 0, 0 };
+
+        dcid_t *p_dcid_sim[2] = { 0, 0 };
+
+        dcid_info_t dcid_info = { 0 };
+
+        int ret = DCID_OK, v, pass;
+
+        dcid_info.backend = dcid_backend_find("sim");
+
+        /*! each document as dcid_read_xml renders it */
+        for(v=0;v<2 && DCID_SUCCESS(ret);v++)
+        {
+            uint8_t raw[DCID_MAX_RAW_SIZE];
+
+            int raw_size = DCID_MAX_RAW_SIZE, size = DCID_MAX_XML_SIZE;
+
+            expected[v] = (char*)malloc(DCID_MAX_XML_SIZE);
+
+            ret = dcid_encode_xml(card_xml[v], raw, &raw_size);
+
+            if(DCID_SUCCESS(ret)) { ret = dcid_decode_image(raw, raw_size, expected[v], &size); }
+
+            unlink(card_path[v]);
+        }
+
+        /*! the second card is programmed first, then both are opened and the first is written */
+        if(DCID_SUCCESS(ret)) { ret = dcid_create(&dcid_info, &p_dcid_sim[1]); }
+        if(DCID_SUCCESS(ret)) { ret = dcid_init(p_dcid_sim[1], (char*)card_path[1]); }
+        if(DCID_SUCCESS(ret)) { int size = strlen(card_xml[1]); ret = dcid_write_xml(p_dcid_sim[1], (char*)card_xml[1], &size); }
+
+        if(p_dcid_sim[1] != 0) { dcid_close(p_dcid_sim[1]); p_dcid_sim[1] = 0; }
+
+        for(v=0;v<2 && DCID_SUCCESS(ret);v++)
+        {
+            ret = dcid_create(&dcid_info, &p_dcid_sim[v]);
+
+            if(DCID_SUCCESS(ret)) { ret = dcid_init(p_dcid_sim[v], (char*)card_path[v]); }
+        }
+
+        if(DCID_SUCCESS(ret)) { int size = strlen(card_xml[0]); ret = dcid_write_xml(p_dcid_sim[0], (char*)card_xml[0], &size); }
+
+        /*! both cards read back, first from the open instances and then from the files */
+        for(pass=0;pass<2 && DCID_SUCCESS(ret);pass++)
+        {
+            for(v=0;v<2 && DCID_SUCCESS(ret);v++)
+            {
+                int size = DCID_MAX_XML_SIZE;
+
+                if(pass == 1)
+                {
+                    dcid_close(p_dcid_sim[v]);
+
+                    p_dcid_sim[v] = 0;
+
+                    ret = dcid_create(&dcid_info, &p_dcid_sim[v]);
+
+                    if(DCID_SUCCESS(ret)) { ret = dcid_init(p_dcid_sim[v], (char*)card_path[v]); }
+                }
+
+                if(DCID_SUCCESS(ret)) { ret = dcid_read_xml(p_dcid_sim[v], tmp_buffer, &size); }
+
+                if(DCID_SUCCESS(ret) && strcmp(expected[v], tmp_buffer) != 0) { ret = DCID_FAIL; }
+
+                if(DCID_FAILED(ret)) { fprintf(stderr, "Error: simulated card %d mixed up (pass := %d)\n", v, pass); }
+            }
+        }
+
+        for(v=0;v<2;v++)
+        {
+            if(p_dcid_sim[v] != 0) { dcid_close(p_dcid_sim[v]); }
+            if(expected[v] != 0) { free(expected[v]); }
+
+            unlink(card_path[v]);
+        }
+
+        if(DCID_FAILED(ret))
+        {
+            fprintf(stderr, "Error: simulated devices failed (ret := %d)\n", ret);
+            goto cleanup;
+        }
+    }
+
+#if defined(CNPLATFORM_sim)
+    printf("Testing simulated bus traffic...\n");
+
+    /*! a fresh instance reads the whole image in one transaction, and rewriting it unchanged writes nothing */
+    {
+        dcid_info_t dcid_info = { 0 };
+
+        dcid_t *p_dcid_fresh = 0;
+
+        dcid_sim_stats_t read_stats = { 0 }, write_stats = { 0 };
+
+        int size = DCID_MAX_XML_SIZE;
+
+        int ret = dcid_create(&dcid_info, &p_dcid_fresh);
+
+        if(DCID_SUCCESS(ret)) { ret = dcid_init(p_dcid_fresh, DCID_DEVICE_PATH); }
+
+        dcid_sim_reset_stats();
+
+        if(DCID_SUCCESS(ret)) { ret = dcid_read_xml(p_dcid_fresh, tmp_buffer, &size); }
+
+        dcid_sim_get_stats(&read_stats);
+        dcid_sim_reset_stats();
+
+        if(DCID_SUCCESS(ret)) { ret = dcid_write_xml(p_dcid_fresh, tmp_buffer, &size); }
+
+        dcid_sim_get_stats(&write_stats);
+
+        if(p_dcid_fresh != 0) { dcid_close(p_dcid_fresh); }
+
+        if(DCID_FAILED(ret) || read_stats.transactions != 1 || write_stats.transactions != 0)
+        {
+            fprintf(stderr, "Error: unexpected bus traffic (ret := %d, read := %u, write := %u transactions)\n", ret, read_stats.transactions, write_stats.transactions);
+            goto cleanup;
+        }
+    }
+#endif
+
     printf("Testing Malformed XML...\n");
 
     /*! test malformed XML, with more than 4 characters per node */
@@ -18,6 +18,8 @@
 /*! serial port device path */
 #if defined(CNPLATFORM_falconwing) || defined(CNPLATFORM_silvermoon)
 #define DCID_DEVICE_PATH "/dev/i2c-0"
+#elif defined(CNPLATFORM_sim)
+#define DCID_DEVICE_PATH "dcid-sim.bin"
 #else
 #define DCID_DEVICE_PATH "/dev/dcid"
 #endif
@@ -101,7 +103,7 @@ int main(int argc, char **argv)
                         if(DCID_FAILED(ret))
                         {
                             printf("Failed!\n");
-                            fprintf(stderr, "Error: dcid_util_read_byte(0x%.08X, %d, 0x%.08X) := %d\n", (uint32_t)p_dcid, v, (uint32_t)&val, ret);
+                            fprintf(stderr, "Error: dcid_util_read_byte(%p, %d, %p) := %d\n", (void*)p_dcid, v, (void*)&val, ret);
                             goto cleanup;
                         }
                     }
@@ -110,7 +112,7 @@ int main(int argc, char **argv)
                         if(DCID_SUCCESS(ret))
                         {
                             printf("Failed!\n");
-                            fprintf(stderr, "Error: dcid_util_read_byte(0x%.08X, %d, 0x%.08X) := %d\n", (uint32_t)p_dcid, v, (uint32_t)&val, ret);
+                            fprintf(stderr, "Error: dcid_util_read_byte(%p, %d, %p) := %d\n", (void*)p_dcid, v, (void*)&val, ret);
                             goto cleanup;
                         }
                     }
@@ -194,7 +196,7 @@ int main(int argc, char **argv)
 
         if(DCID_FAILED(ret))
         {
-            fprintf(stderr, "Error: dcid_util_read_raw(0x%.08X, 0, 0x%.08X, %d) := %d\n", (uint32_t)p_dcid, (uint32_t)tmp_buffer, DCID_MAX_ADDRESS, ret);
+            fprintf(stderr, "Error: dcid_util_read_raw(%p, 0, %p, %d) := %d\n", (void*)p_dcid, tmp_buffer, DCID_MAX_ADDRESS, ret);
             goto cleanup;
         }
 
@@ -205,7 +207,7 @@ int main(int argc, char **argv)
 
         if(DCID_SUCCESS(ret))
         {
-            fprintf(stderr, "Error: dcid_util_read_raw(0x%.08X, 0, 0x%.08X, %d) := %d\n", (uint32_t)p_dcid, (uint32_t)tmp_buffer, DCID_MAX_ADDRESS, ret);
+            fprintf(stderr, "Error: dcid_util_read_raw(%p, 0, %p, %d) := %d\n", (void*)p_dcid, tmp_buffer, DCID_MAX_ADDRESS, ret);
             goto cleanup;
         }
 
@@ -214,6 +216,32 @@ int main(int argc, char **argv)
             fprintf(stderr, "Error: size := %d\n", size);
             goto cleanup;
         }
+
+        /*! test block reads straddling page boundaries against single byte reads */
+        int v;
+
+        size = 0x180;
+
+        ret = dcid_util_read_raw(p_dcid, 0xC0, tmp_buffer, &size);
+
+        if(DCID_FAILED(ret))
+        {
+            fprintf(stderr, "Error: dcid_util_read_raw(%p, 0xC0, %p, 0x180) := %d\n", (void*)p_dcid, tmp_buffer, ret);
+            goto cleanup;
+        }
+
+        for(v=0;v<size;v++)
+        {
+            uint8_t val = 0;
+
+            ret = dcid_util_read_byte(p_dcid, 0xC0+v, &val);
+
+            if(DCID_FAILED(ret) || (val != ((uint8_t*)tmp_buffer)[v]))
+            {
+                fprintf(stderr, "Error: Address %d reported %d by block read, %d by byte read\n", 0xC0+v, ((uint8_t*)tmp_buffer)[v], val);
+                goto cleanup;
+            }
+        }
     }
 
     printf("All Tests Passed!\n");